@@ -0,0 +1,33 @@
+//! Run with `cargo +nightly fuzz run pe_view` from the repository root.
+
+#![no_main]
+
+use libfuzzer_sys::fuzz_target;
+
+// The dumper is a binary crate, so the parser and its error type are compiled in directly.
+#[allow(dead_code)]
+#[path = "../../src/error.rs"]
+mod error;
+
+#[allow(dead_code)]
+#[path = "../../src/remote/pe_view.rs"]
+mod pe_view;
+
+use pe_view::{PeLayout, PeView};
+
+fuzz_target!(|data: &[u8]| {
+    let _ = PeView::required_len(data);
+
+    for layout in [PeLayout::Image, PeLayout::File] {
+        let Ok(view) = PeView::parse(data, layout) else {
+            continue;
+        };
+
+        for section in view.sections() {
+            let _ = section.name();
+            let _ = view.bytes(section.virtual_address, section.raw_size as usize);
+        }
+
+        let _ = view.exports();
+    }
+});
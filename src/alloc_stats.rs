@@ -0,0 +1,339 @@
+use std::cell::Cell;
+#[cfg(feature = "alloc-stats")]
+use std::sync::atomic::Ordering;
+
+/// Parts of a run that allocations are attributed to.
+#[derive(Clone, Copy, Debug, Eq, PartialEq)]
+pub enum Phase {
+    Startup,
+    ModuleScan,
+    TypeScopeTraversal,
+    InterfaceWalk,
+    FileEmission,
+}
+
+impl Phase {
+    const ALL: [Phase; 5] = [
+        Phase::Startup,
+        Phase::ModuleScan,
+        Phase::TypeScopeTraversal,
+        Phase::InterfaceWalk,
+        Phase::FileEmission,
+    ];
+
+    fn name(self) -> &'static str {
+        match self {
+            Phase::Startup => "startup",
+            Phase::ModuleScan => "module scan",
+            Phase::TypeScopeTraversal => "type-scope traversal",
+            Phase::InterfaceWalk => "interface walk",
+            Phase::FileEmission => "file emission",
+        }
+    }
+}
+
+thread_local! {
+    // Read from the global allocator, so it must neither allocate nor need a destructor.
+    static CURRENT_PHASE: Cell<usize> = const { Cell::new(Phase::Startup as usize) };
+}
+
+fn current_phase() -> usize {
+    CURRENT_PHASE
+        .try_with(Cell::get)
+        .unwrap_or(Phase::Startup as usize)
+}
+
+/// Restores the previous phase of the thread when dropped.
+pub struct PhaseGuard {
+    previous: usize,
+}
+
+impl Drop for PhaseGuard {
+    fn drop(&mut self) {
+        CURRENT_PHASE.with(|phase| phase.set(self.previous));
+    }
+}
+
+/// Attributes allocations made by the current thread to `phase` until the guard is dropped.
+///
+/// Each thread tracks its own phase, so dumpers that run concurrently are counted separately.
+/// Threads spawned on behalf of a phase should run their work through `inherit`.
+pub fn enter(phase: Phase) -> PhaseGuard {
+    PhaseGuard {
+        previous: CURRENT_PHASE.with(|current| current.replace(phase as usize)),
+    }
+}
+
+/// Wraps `f` so that it runs in the phase of the thread calling `inherit`, wherever it is run.
+pub fn inherit<F, T>(f: F) -> impl FnOnce() -> T + Send
+where
+    F: FnOnce() -> T + Send,
+{
+    let phase = current_phase();
+
+    move || {
+        let previous = CURRENT_PHASE.with(|current| current.replace(phase));
+
+        let _guard = PhaseGuard { previous };
+
+        f()
+    }
+}
+
+#[cfg(feature = "alloc-stats")]
+mod counting {
+    use std::alloc::{GlobalAlloc, Layout, System};
+    use std::mem;
+    use std::sync::atomic::{AtomicUsize, Ordering};
+
+    use super::{current_phase, Phase};
+
+    pub struct PhaseStats {
+        pub allocations: AtomicUsize,
+        pub bytes: AtomicUsize,
+        pub live_bytes: AtomicUsize,
+        pub peak_live_bytes: AtomicUsize,
+    }
+
+    const EMPTY: PhaseStats = PhaseStats {
+        allocations: AtomicUsize::new(0),
+        bytes: AtomicUsize::new(0),
+        live_bytes: AtomicUsize::new(0),
+        peak_live_bytes: AtomicUsize::new(0),
+    };
+
+    pub static STATS: [PhaseStats; Phase::ALL.len()] = [EMPTY; Phase::ALL.len()];
+
+    /// Forwards to the system allocator and counts every allocation.
+    ///
+    /// Each allocation is prefixed with the phase it was made in, so its bytes leave the live
+    /// bytes of that phase when freed, whichever thread or phase frees it.
+    pub struct CountingAllocator;
+
+    impl CountingAllocator {
+        /// Returns the layout with room for the phase prefix, and the offset of the caller's
+        /// memory in it.
+        fn tagged(layout: Layout) -> Option<(Layout, usize)> {
+            let offset = layout.align().max(mem::size_of::<usize>());
+
+            let tagged =
+                Layout::from_size_align(layout.size().checked_add(offset)?, offset).ok()?;
+
+            Some((tagged, offset))
+        }
+
+        unsafe fn finish_alloc(base: *mut u8, offset: usize, size: usize) -> *mut u8 {
+            if base.is_null() {
+                return base;
+            }
+
+            let phase = current_phase();
+            let ptr = base.add(offset);
+
+            (ptr as *mut usize).sub(1).write(phase);
+
+            Self::record_alloc(phase, size);
+
+            ptr
+        }
+
+        unsafe fn phase_of(ptr: *mut u8) -> usize {
+            (ptr as *const usize).sub(1).read()
+        }
+
+        fn record_alloc(phase: usize, size: usize) {
+            let stats = &STATS[phase];
+
+            stats.allocations.fetch_add(1, Ordering::Relaxed);
+            stats.bytes.fetch_add(size, Ordering::Relaxed);
+
+            let live = stats.live_bytes.fetch_add(size, Ordering::Relaxed) + size;
+
+            stats.peak_live_bytes.fetch_max(live, Ordering::Relaxed);
+        }
+
+        fn record_dealloc(phase: usize, size: usize) {
+            STATS[phase].live_bytes.fetch_sub(size, Ordering::Relaxed);
+        }
+    }
+
+    unsafe impl GlobalAlloc for CountingAllocator {
+        unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+            match Self::tagged(layout) {
+                Some((tagged, offset)) => {
+                    Self::finish_alloc(System.alloc(tagged), offset, layout.size())
+                }
+                None => std::ptr::null_mut(),
+            }
+        }
+
+        unsafe fn alloc_zeroed(&self, layout: Layout) -> *mut u8 {
+            match Self::tagged(layout) {
+                Some((tagged, offset)) => {
+                    Self::finish_alloc(System.alloc_zeroed(tagged), offset, layout.size())
+                }
+                None => std::ptr::null_mut(),
+            }
+        }
+
+        unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+            // The layout was already checked when the memory was allocated.
+            let (tagged, offset) = Self::tagged(layout).unwrap_unchecked();
+
+            let phase = Self::phase_of(ptr);
+
+            System.dealloc(ptr.sub(offset), tagged);
+
+            Self::record_dealloc(phase, layout.size());
+        }
+
+        unsafe fn realloc(&self, ptr: *mut u8, layout: Layout, new_size: usize) -> *mut u8 {
+            let (tagged, offset) = Self::tagged(layout).unwrap_unchecked();
+
+            if Layout::from_size_align(new_size.saturating_add(offset), offset).is_err() {
+                return std::ptr::null_mut();
+            }
+
+            let phase = Self::phase_of(ptr);
+
+            let base = System.realloc(ptr.sub(offset), tagged, new_size + offset);
+
+            if base.is_null() {
+                return base;
+            }
+
+            Self::record_dealloc(phase, layout.size());
+
+            Self::finish_alloc(base, offset, new_size)
+        }
+    }
+
+    #[global_allocator]
+    static ALLOCATOR: CountingAllocator = CountingAllocator;
+}
+
+/// Logs the allocations of every phase and the peak resident memory of the process.
+///
+/// The peak live bytes of a phase are the most bytes allocated in that phase and not yet freed at
+/// any one time, so memory held by dumpers running alongside is not included. Allocations are
+/// only counted when built with the `alloc-stats` feature.
+pub fn log_report() {
+    #[cfg(feature = "alloc-stats")]
+    {
+        log::info!(
+            "{:<22} {:>12} {:>16} {:>16}",
+            "Phase",
+            "Allocations",
+            "Bytes",
+            "Peak live bytes"
+        );
+
+        for phase in Phase::ALL {
+            let stats = &counting::STATS[phase as usize];
+
+            log::info!(
+                "{:<22} {:>12} {:>16} {:>16}",
+                phase.name(),
+                stats.allocations.load(Ordering::Relaxed),
+                stats.bytes.load(Ordering::Relaxed),
+                stats.peak_live_bytes.load(Ordering::Relaxed)
+            );
+        }
+    }
+
+    if let Some(peak_rss) = peak_rss() {
+        log::info!("Peak resident memory: {} bytes", peak_rss);
+    }
+}
+
+#[cfg(target_os = "linux")]
+fn peak_rss() -> Option<usize> {
+    let status = std::fs::read_to_string("/proc/self/status").ok()?;
+
+    let kilobytes = status
+        .lines()
+        .find_map(|line| line.strip_prefix("VmHWM:"))?
+        .trim()
+        .trim_end_matches("kB")
+        .trim()
+        .parse::<usize>()
+        .ok()?;
+
+    Some(kilobytes * 1024)
+}
+
+#[cfg(windows)]
+fn peak_rss() -> Option<usize> {
+    use windows::Win32::System::ProcessStatus::{GetProcessMemoryInfo, PROCESS_MEMORY_COUNTERS};
+    use windows::Win32::System::Threading::GetCurrentProcess;
+
+    let mut counters = PROCESS_MEMORY_COUNTERS::default();
+
+    let _ = unsafe {
+        GetProcessMemoryInfo(
+            GetCurrentProcess(),
+            &mut counters,
+            std::mem::size_of::<PROCESS_MEMORY_COUNTERS>() as u32,
+        )
+    };
+
+    (counters.PeakWorkingSetSize != 0).then_some(counters.PeakWorkingSetSize)
+}
+
+#[cfg(not(any(target_os = "linux", windows)))]
+fn peak_rss() -> Option<usize> {
+    None
+}
+
+#[cfg(test)]
+mod tests {
+    use std::thread;
+
+    use super::*;
+
+    #[test]
+    fn phases_are_per_thread() {
+        let _scan = enter(Phase::ModuleScan);
+
+        thread::scope(|scope| {
+            scope.spawn(|| {
+                let _walk = enter(Phase::InterfaceWalk);
+
+                assert_eq!(current_phase(), Phase::InterfaceWalk as usize);
+            });
+
+            scope.spawn(inherit(|| {
+                assert_eq!(current_phase(), Phase::ModuleScan as usize);
+
+                let _emission = enter(Phase::FileEmission);
+            }));
+        });
+
+        assert_eq!(current_phase(), Phase::ModuleScan as usize);
+    }
+
+    #[cfg(feature = "alloc-stats")]
+    #[test]
+    fn live_bytes_stay_with_the_allocating_phase() {
+        let stats = &counting::STATS[Phase::TypeScopeTraversal as usize];
+
+        let buffer = {
+            let _traversal = enter(Phase::TypeScopeTraversal);
+
+            vec![0u8; 1 << 20]
+        };
+
+        assert!(stats.live_bytes.load(Ordering::Relaxed) >= 1 << 20);
+        assert!(stats.peak_live_bytes.load(Ordering::Relaxed) >= 1 << 20);
+
+        thread::spawn(move || {
+            let _emission = enter(Phase::FileEmission);
+
+            drop(buffer);
+        })
+        .join()
+        .unwrap();
+
+        assert!(stats.live_bytes.load(Ordering::Relaxed) < 1 << 20);
+    }
+}
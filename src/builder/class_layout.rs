@@ -0,0 +1,111 @@
+use std::collections::BTreeMap;
+
+/// A field of a class as it sits in memory.
+#[derive(Clone, Debug, PartialEq)]
+pub struct FieldLayout {
+    pub name: String,
+    pub offset: usize,
+    pub size: Option<usize>,
+    pub type_name: String,
+}
+
+/// The memory layout of a class, used by builders that emit struct definitions.
+#[derive(Clone, Debug, Default, PartialEq)]
+pub struct ClassLayout {
+    pub size: usize,
+    pub parent: Option<String>,
+    pub fields: Vec<FieldLayout>,
+    pub read_spans: Vec<ReadSpan>,
+}
+
+/// Class layouts keyed by the same namespace names as `Entries`.
+pub type ClassLayouts = BTreeMap<String, ClassLayout>;
+
+/// A contiguous byte range of a class that covers one or more fields.
+#[derive(Clone, Debug, PartialEq)]
+pub struct ReadSpan {
+    pub offset: usize,
+    pub size: usize,
+    pub fields: Vec<String>,
+}
+
+impl ClassLayout {
+    /// Merges the fields, sorted by offset, into the fewest byte ranges such that no range skips
+    /// more than `max_gap` bytes between two fields.
+    ///
+    /// Fields of unknown size are assumed to extend to the next field or the end of the class.
+    pub fn read_spans(&self, max_gap: usize) -> Vec<ReadSpan> {
+        let mut fields: Vec<&FieldLayout> = self.fields.iter().collect();
+
+        fields.sort_by_key(|field| field.offset);
+
+        let mut spans: Vec<ReadSpan> = Vec::new();
+
+        for (i, field) in fields.iter().enumerate() {
+            let size = field.size.unwrap_or_else(|| {
+                fields[i + 1..]
+                    .iter()
+                    .map(|next| next.offset)
+                    .find(|&offset| offset > field.offset)
+                    .unwrap_or(self.size)
+                    .saturating_sub(field.offset)
+                    .max(1)
+            });
+
+            let end = field.offset + size;
+
+            match spans.last_mut() {
+                Some(span) if field.offset <= span.offset + span.size + max_gap => {
+                    span.size = span.size.max(end - span.offset);
+                    span.fields.push(field.name.clone());
+                }
+                _ => spans.push(ReadSpan {
+                    offset: field.offset,
+                    size,
+                    fields: vec![field.name.clone()],
+                }),
+            }
+        }
+
+        spans
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn field(name: &str, offset: usize, size: Option<usize>) -> FieldLayout {
+        FieldLayout {
+            name: name.to_string(),
+            offset,
+            size,
+            type_name: String::new(),
+        }
+    }
+
+    #[test]
+    fn read_spans() {
+        let layout = ClassLayout {
+            size: 0x200,
+            parent: None,
+            fields: vec![
+                field("m_c", 0x100, Some(4)),
+                field("m_a", 0x10, Some(8)),
+                field("m_b", 0x20, Some(4)),
+                field("m_d", 0x108, None),
+            ],
+            read_spans: Vec::new(),
+        };
+
+        let spans: Vec<(usize, usize)> = layout
+            .read_spans(0x10)
+            .iter()
+            .map(|span| (span.offset, span.size))
+            .collect();
+
+        assert_eq!(spans, vec![(0x10, 0x14), (0x100, 0x100)]);
+        assert_eq!(layout.read_spans(0x100).len(), 1);
+        assert_eq!(layout.read_spans(0).len(), 4);
+    }
+}
@@ -1,26 +1,407 @@
-use std::io::{Result, Write};
+use std::collections::HashSet;
+use std::fs;
+use std::io::{Error, ErrorKind, Result, Write};
+use std::mem;
+use std::path::{Path, PathBuf};
 
-use super::FileBuilder;
+use crate::sdk::SchemaType;
 
-#[derive(Debug, PartialEq)]
-pub struct CppFileBuilder;
+use super::{file_name, ClassLayout, FileBuilder};
+
+const FNV_OFFSET_BASIS: u64 = 0xCBF29CE484222325;
+const FNV_PRIME: u64 = 0x100000001B3;
+
+const FIELD_PRELUDE: &str = r#"#ifndef CS2_DUMPER_FIELD
+#define CS2_DUMPER_FIELD
+
+namespace cs2_dumper {
+    template <std::size_t Size>
+    struct Blob {
+        std::uint8_t data[Size];
+    };
+
+    template <typename T, std::ptrdiff_t Offset>
+    struct Field {
+        using type = T;
+
+        static constexpr std::ptrdiff_t offset = Offset;
+        static constexpr std::size_t size = sizeof(T);
+
+        constexpr operator std::ptrdiff_t() const noexcept {
+            return Offset;
+        }
+    };
+}
+
+#endif
+
+"#;
+
+const LOOKUP_PRELUDE: &str = r#"    struct Entry {
+        std::uint64_t hash;
+        std::ptrdiff_t value;
+    };
+
+    constexpr std::uint64_t fnv1a(std::string_view name) noexcept {
+        std::uint64_t hash = 0xCBF29CE484222325;
+
+        for (const char c : name) {
+            hash ^= static_cast<std::uint8_t>(c);
+            hash *= 0x100000001B3;
+        }
+
+        return hash;
+    }
+
+"#;
+
+const LOOKUP_FIND: &str = r#"    constexpr std::size_t count = sizeof(entries) / sizeof(Entry);
+
+    // Returns the value of `name` ("Namespace::name"), or `fallback` if there is none.
+    constexpr std::ptrdiff_t find(std::string_view name, std::ptrdiff_t fallback = -1) noexcept {
+        const std::uint64_t hash = fnv1a(name);
+
+        std::size_t low = 0;
+        std::size_t high = count;
+
+        while (low < high) {
+            const std::size_t mid = low + (high - low) / 2;
+
+            if (entries[mid].hash < hash)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+
+        return low < count && entries[low].hash == hash ? entries[low].value : fallback;
+    }
+"#;
+
+#[derive(Clone, Copy, Debug, Default, PartialEq)]
+pub struct CppFileBuilderOptions {
+    /// Emit a `constexpr` table of every entry sorted by the FNV-1a hash of its qualified name,
+    /// along with a `constexpr` lookup function.
+    pub lookup_tables: bool,
+
+    /// Emit a packed `Layout` struct for every class with a known size, with explicit padding
+    /// and `static_assert`s that check it against the dumped offsets.
+    pub structs: bool,
+
+    /// Emit fields as `constexpr Field<T, offset>` descriptors instead of plain offsets. Types
+    /// without a C++ equivalent become a `Blob` of the field's size.
+    pub typed_fields: bool,
+
+    /// Write every namespace to its own header under `generated/<file>/` and turn the main
+    /// header into an umbrella that includes them. Headers are only rewritten when their
+    /// contents change, so unchanged classes keep their timestamps.
+    pub split_headers: bool,
+}
+
+#[derive(Debug, Default, PartialEq)]
+pub struct CppFileBuilder {
+    options: CppFileBuilderOptions,
+    file_path: PathBuf,
+    file_name: String,
+    namespace: String,
+    lookup_entries: Vec<(u64, usize, String)>,
+    pending_fields: Vec<(String, usize, Option<String>)>,
+    class_header: Vec<u8>,
+    class_headers: HashSet<String>,
+}
+
+impl CppFileBuilder {
+    pub fn new(options: CppFileBuilderOptions) -> Self {
+        Self {
+            options,
+            ..Default::default()
+        }
+    }
+
+    /// Runs `write` against the header of the current class when splitting headers, or against
+    /// `output` otherwise.
+    fn redirect<F>(&mut self, output: &mut dyn Write, write: F) -> Result<()>
+    where
+        F: FnOnce(&mut Self, &mut dyn Write) -> Result<()>,
+    {
+        if !self.options.split_headers {
+            return write(self, output);
+        }
+
+        let mut header = mem::take(&mut self.class_header);
+
+        let result = write(self, &mut header);
+
+        self.class_header = header;
+
+        result
+    }
+
+    fn write_includes(&self, output: &mut dyn Write, string_view: bool) -> Result<()> {
+        write!(output, "#include <cstddef>\n")?;
+
+        if self.options.lookup_tables || self.options.structs || self.options.typed_fields {
+            write!(output, "#include <cstdint>\n")?;
+        }
+
+        if string_view {
+            write!(output, "#include <string_view>\n")?;
+        }
+
+        write!(output, "\n")
+    }
+
+    /// Writes the header of the current class to disk and includes it from the umbrella header.
+    fn finish_class_header(&mut self, output: &mut dyn Write) -> Result<()> {
+        let path = self.file_path.join(format!("{}.hpp", self.namespace));
+
+        write_if_changed(&path, &self.class_header)?;
+
+        self.class_header.clear();
+        self.class_headers.insert(self.namespace.clone());
+
+        write!(
+            output,
+            "#include \"{}/{}.hpp\"\n",
+            self.file_name, self.namespace
+        )
+    }
+
+    /// Removes headers left over from classes that no longer exist.
+    fn remove_stale_class_headers(&mut self) -> Result<()> {
+        for entry in fs::read_dir(&self.file_path)? {
+            let path = entry?.path();
+
+            let is_stale = path
+                .extension()
+                .map_or(false, |extension| extension == "hpp")
+                && path
+                    .file_stem()
+                    .and_then(|stem| stem.to_str())
+                    .map_or(false, |stem| !self.class_headers.contains(stem));
+
+            if is_stale {
+                fs::remove_file(path)?;
+            }
+        }
+
+        self.class_headers.clear();
+
+        Ok(())
+    }
+
+    fn write_lookup_table(&mut self, output: &mut dyn Write) -> Result<()> {
+        self.lookup_entries.sort_by_key(|&(hash, _, _)| hash);
+
+        // `find` can only tell names apart by their hash, so two names with the same hash would
+        // silently return the value of the wrong one.
+        if let Some(pair) = self
+            .lookup_entries
+            .windows(2)
+            .find(|pair| pair[0].0 == pair[1].0 && pair[0].2 != pair[1].2)
+        {
+            return Err(Error::new(
+                ErrorKind::InvalidData,
+                format!(
+                    "{} and {} have the same hash {:#018X}",
+                    pair[0].2, pair[1].2, pair[0].0
+                ),
+            ));
+        }
+
+        self.lookup_entries.dedup_by_key(|&mut (hash, _, _)| hash);
+
+        write!(
+            output,
+            "\n\nnamespace {}_lookup {{\n",
+            self.file_name.replace(".", "_")
+        )?;
+
+        write!(output, "{}", LOOKUP_PRELUDE)?;
+
+        write!(output, "    constexpr Entry entries[] = {{\n")?;
+
+        for (hash, value, name) in &self.lookup_entries {
+            write!(
+                output,
+                "        {{{:#018X}, {:#X}}}, // {}\n",
+                hash, value, name
+            )?;
+        }
+
+        write!(output, "    }};\n\n")?;
+
+        write!(output, "{}}}", LOOKUP_FIND)?;
+
+        self.lookup_entries.clear();
+
+        Ok(())
+    }
+
+    /// Writes the fields held back by `write_variable`, sized from `layout` where available.
+    fn write_pending_fields(
+        &mut self,
+        output: &mut dyn Write,
+        layout: Option<&ClassLayout>,
+    ) -> Result<()> {
+        for (name, value, type_name) in self.pending_fields.drain(..) {
+            let Some(type_name) = type_name else {
+                write_constant(output, &name, value, None)?;
+
+                continue;
+            };
+
+            let size = layout
+                .and_then(|layout| layout.fields.iter().find(|field| field.name == name))
+                .and_then(|field| field.size);
+
+            let field_type = match (cpp_type(&type_name), size) {
+                (Some(cpp_type), _) => cpp_type,
+                (None, Some(size)) => format!("cs2_dumper::Blob<{:#X}>", size),
+                (None, None) => {
+                    write_constant(output, &name, value, Some(&type_name))?;
+
+                    continue;
+                }
+            };
+
+            write!(
+                output,
+                "    constexpr cs2_dumper::Field<{}, {:#X}> {}{{}}; // {}\n",
+                field_type, value, name, type_name
+            )?;
+        }
+
+        Ok(())
+    }
+
+    fn write_struct(&self, output: &mut dyn Write, layout: &ClassLayout) -> Result<()> {
+        let mut fields: Vec<_> = layout.fields.iter().collect();
+
+        fields.sort_by_key(|field| field.offset);
+
+        write!(output, "\n    #pragma pack(push, 1)\n")?;
+        write!(output, "    struct Layout {{\n")?;
+
+        let mut cursor = 0;
+        let mut placed = Vec::with_capacity(fields.len());
+
+        for (i, field) in fields.iter().enumerate() {
+            // Fields that overlap the previous one (bitfields, unions) can't be placed.
+            if field.offset < cursor || field.offset >= layout.size {
+                write!(
+                    output,
+                    "        // {} @ {:#X} ({})\n",
+                    field.name, field.offset, field.type_name
+                )?;
+
+                continue;
+            }
+
+            if field.offset > cursor {
+                write_padding(output, cursor, field.offset - cursor, layout, i == 0)?;
+            }
+
+            let next_offset = fields[i + 1..]
+                .iter()
+                .map(|next| next.offset)
+                .find(|&offset| offset > field.offset)
+                .unwrap_or(layout.size)
+                .min(layout.size);
+
+            let size = field
+                .size
+                .filter(|&size| field.offset + size <= next_offset)
+                .unwrap_or(next_offset - field.offset);
+
+            match cpp_type(&field.type_name).filter(|_| Some(size) == field.size) {
+                Some(cpp_type) => write!(
+                    output,
+                    "        {} {}; // {}\n",
+                    cpp_type, field.name, field.type_name
+                )?,
+                None => write!(
+                    output,
+                    "        std::uint8_t {}[{:#X}]; // {}\n",
+                    field.name, size, field.type_name
+                )?,
+            }
+
+            cursor = field.offset + size;
+
+            placed.push(field.name.as_str());
+        }
+
+        if cursor < layout.size {
+            write_padding(output, cursor, layout.size - cursor, layout, false)?;
+        }
+
+        write!(output, "    }};\n")?;
+        write!(output, "    #pragma pack(pop)\n\n")?;
+
+        write!(
+            output,
+            "    static_assert(sizeof(Layout) == {:#X});\n",
+            layout.size
+        )?;
+
+        for name in placed {
+            write!(
+                output,
+                "    static_assert(offsetof(Layout, {}) == {});\n",
+                name, name
+            )?;
+        }
+
+        Ok(())
+    }
+}
 
 impl FileBuilder for CppFileBuilder {
     fn extension(&mut self) -> &str {
         "hpp"
     }
 
-    fn write_top_level(&mut self, output: &mut dyn Write) -> Result<()> {
+    fn write_top_level(&mut self, output: &mut dyn Write, file_path: &Path) -> Result<()> {
+        self.file_path = file_path.to_path_buf();
+        self.file_name = file_name(file_path);
+
+        // Class headers go into a directory named after the umbrella header.
+        if self.options.split_headers {
+            fs::create_dir_all(file_path)?;
+        }
+
         write!(output, "#pragma once\n\n")?;
-        write!(output, "#include <cstddef>\n\n")?;
+
+        self.write_includes(output, self.options.lookup_tables)?;
+
+        if self.options.typed_fields && !self.options.split_headers {
+            write!(output, "{}", FIELD_PRELUDE)?;
+        }
 
         Ok(())
     }
 
     fn write_namespace(&mut self, output: &mut dyn Write, name: &str) -> Result<()> {
-        write!(output, "namespace {} {{\n", name)?;
+        self.namespace = name.to_string();
 
-        Ok(())
+        self.redirect(output, |builder, output| {
+            if builder.options.split_headers {
+                write!(output, "#pragma once\n\n")?;
+
+                builder.write_includes(output, false)?;
+
+                write!(
+                    output,
+                    "// Created using https://github.com/a2x/cs2-dumper\n\n"
+                )?;
+
+                if builder.options.typed_fields {
+                    write!(output, "{}", FIELD_PRELUDE)?;
+                }
+            }
+
+            write!(output, "namespace {} {{\n", name)
+        })
     }
 
     fn write_variable(
@@ -30,22 +411,407 @@ impl FileBuilder for CppFileBuilder {
         value: usize,
         comment: Option<&str>,
     ) -> Result<()> {
-        match comment {
-            Some(comment) => write!(
-                output,
-                "    constexpr std::ptrdiff_t {} = {:#X}; // {}\n",
-                name, value, comment
-            ),
-            None => write!(
-                output,
-                "    constexpr std::ptrdiff_t {} = {:#X};\n",
-                name, value
-            ),
+        if self.options.lookup_tables {
+            let qualified_name = format!("{}::{}", self.namespace, name);
+
+            self.lookup_entries
+                .push((fnv1a(qualified_name.as_bytes()), value, qualified_name));
         }
+
+        // Typed fields need the field sizes, which only arrive with the layout.
+        if self.options.typed_fields {
+            self.pending_fields
+                .push((name.to_string(), value, comment.map(str::to_string)));
+
+            return Ok(());
+        }
+
+        self.redirect(output, |_, output| {
+            write_constant(output, name, value, comment)
+        })
+    }
+
+    fn write_layout(&mut self, output: &mut dyn Write, layout: &ClassLayout) -> Result<()> {
+        self.redirect(output, |builder, output| {
+            builder.write_pending_fields(output, Some(layout))?;
+
+            if !layout.read_spans.is_empty() {
+                write!(
+                    output,
+                    "\n    // {{offset, size}} ranges covering every field.\n"
+                )?;
+                write!(
+                    output,
+                    "    constexpr std::ptrdiff_t read_spans[][2] = {{\n"
+                )?;
+
+                for span in &layout.read_spans {
+                    write!(
+                        output,
+                        "        {{{:#X}, {:#X}}}, // {}\n",
+                        span.offset,
+                        span.size,
+                        span.fields.join(", ")
+                    )?;
+                }
+
+                write!(output, "    }};\n")?;
+            }
+
+            if builder.options.structs && layout.size != 0 {
+                builder.write_struct(output, layout)?;
+            }
+
+            Ok(())
+        })
     }
 
     fn write_closure(&mut self, output: &mut dyn Write, eof: bool) -> Result<()> {
-        write!(output, "{}", if eof { "}" } else { "}\n\n" })?;
+        if self.options.split_headers {
+            self.redirect(output, |builder, output| {
+                builder.write_pending_fields(output, None)?;
+
+                write!(output, "}}\n")
+            })?;
+
+            self.finish_class_header(output)?;
+
+            if eof {
+                self.remove_stale_class_headers()?;
+            }
+        } else {
+            self.write_pending_fields(output, None)?;
+
+            write!(output, "{}", if eof { "}" } else { "}\n\n" })?;
+        }
+
+        if eof && self.options.lookup_tables {
+            self.write_lookup_table(output)?;
+        }
+
+        Ok(())
+    }
+}
+
+/// Returns the C++ type for schema types that map onto a fundamental type.
+fn cpp_type(type_name: &str) -> Option<String> {
+    match type_name {
+        "bool" | "char" => Some(type_name.to_string()),
+        // Pointers into the game's address space, which is always 64-bit.
+        _ if type_name.ends_with('*') => Some("std::uint64_t".to_string()),
+        _ => SchemaType::primitive_type_name(type_name).map(|name| match name {
+            "float" | "double" => name.to_string(),
+            _ => format!("std::{}", name),
+        }),
+    }
+}
+
+fn write_constant(
+    output: &mut dyn Write,
+    name: &str,
+    value: usize,
+    comment: Option<&str>,
+) -> Result<()> {
+    match comment {
+        Some(comment) => write!(
+            output,
+            "    constexpr std::ptrdiff_t {} = {:#X}; // {}\n",
+            name, value, comment
+        ),
+        None => write!(
+            output,
+            "    constexpr std::ptrdiff_t {} = {:#X};\n",
+            name, value
+        ),
+    }
+}
+
+/// Writes `data` to `path` unless the file already holds exactly that.
+fn write_if_changed(path: &Path, data: &[u8]) -> Result<()> {
+    match fs::read(path) {
+        Ok(existing) if existing == data => Ok(()),
+        _ => fs::write(path, data),
+    }
+}
+
+fn write_padding(
+    output: &mut dyn Write,
+    offset: usize,
+    size: usize,
+    layout: &ClassLayout,
+    inherited: bool,
+) -> Result<()> {
+    match layout.parent.as_deref().filter(|_| inherited) {
+        Some(parent) => write!(
+            output,
+            "        char pad_{:04X}[{:#X}]; // {}\n",
+            offset, size, parent
+        ),
+        None => write!(output, "        char pad_{:04X}[{:#X}];\n", offset, size),
+    }
+}
+
+fn fnv1a(data: &[u8]) -> u64 {
+    data.iter().fold(FNV_OFFSET_BASIS, |hash, &byte| {
+        (hash ^ byte as u64).wrapping_mul(FNV_PRIME)
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use std::env;
+    use std::time::{Duration, SystemTime};
+
+    use super::*;
+
+    use crate::builder::FieldLayout;
+
+    fn render(options: CppFileBuilderOptions, namespaces: &[(&str, &[(&str, usize)])]) -> String {
+        let mut builder = CppFileBuilder::new(options);
+
+        let mut output = Vec::new();
+
+        builder
+            .write_top_level(&mut output, Path::new("client.dll"))
+            .unwrap();
+
+        for (i, (namespace, variables)) in namespaces.iter().enumerate() {
+            builder.write_namespace(&mut output, namespace).unwrap();
+
+            for &(name, value) in variables.iter() {
+                builder
+                    .write_variable(&mut output, name, value, None)
+                    .unwrap();
+            }
+
+            builder
+                .write_closure(&mut output, i == namespaces.len() - 1)
+                .unwrap();
+        }
+
+        String::from_utf8(output).unwrap()
+    }
+
+    #[test]
+    fn lookup_table() {
+        let options = CppFileBuilderOptions {
+            lookup_tables: true,
+            ..Default::default()
+        };
+
+        let output = render(
+            options,
+            &[
+                ("C_Base", &[("m_iHealth", 0x10), ("m_iTeamNum", 0x18)]),
+                ("C_Derived", &[("m_flSpeed", 0x20)]),
+            ],
+        );
+
+        let mut expected = vec![
+            ("C_Base::m_iHealth", 0x10),
+            ("C_Base::m_iTeamNum", 0x18),
+            ("C_Derived::m_flSpeed", 0x20),
+        ];
+
+        expected.sort_by_key(|(name, _)| fnv1a(name.as_bytes()));
+
+        let entries: Vec<String> = expected
+            .iter()
+            .map(|(name, value)| {
+                format!(
+                    "        {{{:#018X}, {:#X}}}, // {}\n",
+                    fnv1a(name.as_bytes()),
+                    value,
+                    name
+                )
+            })
+            .collect();
+
+        assert!(output.contains("namespace client_dll_lookup {"));
+        assert!(output.contains(&format!(
+            "    constexpr Entry entries[] = {{\n{}    }};",
+            entries.concat()
+        )));
+        assert!(output.contains("constexpr std::ptrdiff_t find(std::string_view name"));
+
+        // Names that collide can't be told apart by `find`.
+        let mut builder = CppFileBuilder::new(options);
+
+        builder.lookup_entries = vec![
+            (0x1, 0x10, "A::m_a".to_string()),
+            (0x1, 0x20, "B::m_b".to_string()),
+        ];
+
+        assert!(builder.write_lookup_table(&mut Vec::new()).is_err());
+    }
+
+    fn field(name: &str, offset: usize, size: Option<usize>, type_name: &str) -> FieldLayout {
+        FieldLayout {
+            name: name.to_string(),
+            offset,
+            size,
+            type_name: type_name.to_string(),
+        }
+    }
+
+    #[test]
+    fn struct_layout() -> Result<()> {
+        let layout = ClassLayout {
+            size: 0x40,
+            parent: Some("C_Base".to_string()),
+            fields: vec![
+                field("m_vecOrigin", 0x18, Some(0xC), "Vector"),
+                field("m_iHealth", 0x10, Some(4), "int32"),
+                field("m_bAlive", 0x14, Some(1), "bool"),
+                field("m_nFlags", 0x18, None, "bitfield:3"),
+            ],
+            read_spans: Vec::new(),
+        };
+
+        let mut builder = CppFileBuilder::new(CppFileBuilderOptions {
+            structs: true,
+            ..Default::default()
+        });
+
+        let mut output = Vec::new();
+
+        builder.write_layout(&mut output, &layout)?;
+
+        // The parent's fields are padding, and overlapping fields are only listed.
+        assert_eq!(
+            String::from_utf8(output).unwrap(),
+            "
+    #pragma pack(push, 1)
+    struct Layout {
+        char pad_0000[0x10]; // C_Base
+        std::int32_t m_iHealth; // int32
+        bool m_bAlive; // bool
+        char pad_0015[0x3];
+        std::uint8_t m_vecOrigin[0xC]; // Vector
+        // m_nFlags @ 0x18 (bitfield:3)
+        char pad_0024[0x1C];
+    };
+    #pragma pack(pop)
+
+    static_assert(sizeof(Layout) == 0x40);
+    static_assert(offsetof(Layout, m_iHealth) == m_iHealth);
+    static_assert(offsetof(Layout, m_bAlive) == m_bAlive);
+    static_assert(offsetof(Layout, m_vecOrigin) == m_vecOrigin);
+"
+        );
+
+        Ok(())
+    }
+
+    #[test]
+    fn typed_fields() -> Result<()> {
+        assert_eq!(SchemaType::primitive_type_name("int32"), Some("int32_t"));
+        assert_eq!(SchemaType::primitive_type_name("uint8_t"), Some("uint8_t"));
+        assert_eq!(SchemaType::primitive_type_name("float32"), Some("float"));
+        assert_eq!(SchemaType::primitive_type_name("Vector"), None);
+
+        let layout = ClassLayout {
+            size: 0x40,
+            fields: vec![field("m_vecOrigin", 0x20, Some(0xC), "Vector")],
+            ..Default::default()
+        };
+
+        let mut builder = CppFileBuilder::new(CppFileBuilderOptions {
+            typed_fields: true,
+            ..Default::default()
+        });
+
+        let mut output = Vec::new();
+
+        builder.write_top_level(&mut output, Path::new("client.dll"))?;
+        builder.write_namespace(&mut output, "C_Base")?;
+
+        for (name, value, type_name) in [
+            ("m_iHealth", 0x10, "int32"),
+            ("m_flSpeed", 0x14, "float32"),
+            ("m_bAlive", 0x18, "bool"),
+            ("m_pOwner", 0x28, "CEntity*"),
+            ("m_vecOrigin", 0x20, "Vector"),
+            ("m_hUnknown", 0x30, "CHandle<C_Base>"),
+        ] {
+            builder.write_variable(&mut output, name, value, Some(type_name))?;
+        }
+
+        builder.write_layout(&mut output, &layout)?;
+        builder.write_closure(&mut output, true)?;
+
+        let output = String::from_utf8(output).unwrap();
+
+        assert!(output.contains(FIELD_PRELUDE));
+
+        // Types without a C++ equivalent become a blob of the field's size, or a plain offset if
+        // the size is unknown.
+        assert!(output.contains(
+            "namespace C_Base {
+    constexpr cs2_dumper::Field<std::int32_t, 0x10> m_iHealth{}; // int32
+    constexpr cs2_dumper::Field<float, 0x14> m_flSpeed{}; // float32
+    constexpr cs2_dumper::Field<bool, 0x18> m_bAlive{}; // bool
+    constexpr cs2_dumper::Field<std::uint64_t, 0x28> m_pOwner{}; // CEntity*
+    constexpr cs2_dumper::Field<cs2_dumper::Blob<0xC>, 0x20> m_vecOrigin{}; // Vector
+    constexpr std::ptrdiff_t m_hUnknown = 0x30; // CHandle<C_Base>
+}"
+        ));
+
+        Ok(())
+    }
+
+    #[test]
+    fn split_headers() -> Result<()> {
+        let root = env::temp_dir().join(format!("cs2-dumper-split-{}", std::process::id()));
+
+        let file_path = root.join("client.dll");
+
+        let options = CppFileBuilderOptions {
+            split_headers: true,
+            ..Default::default()
+        };
+
+        let render = |namespaces: &[&str]| -> Result<String> {
+            let mut builder = CppFileBuilder::new(options);
+
+            let mut output = Vec::new();
+
+            builder.write_top_level(&mut output, &file_path)?;
+
+            for (i, namespace) in namespaces.iter().enumerate() {
+                builder.write_namespace(&mut output, namespace)?;
+                builder.write_variable(&mut output, "m_iHealth", 0x10, None)?;
+                builder.write_closure(&mut output, i == namespaces.len() - 1)?;
+            }
+
+            Ok(String::from_utf8(output).unwrap())
+        };
+
+        let umbrella = render(&["C_Base", "C_Removed"])?;
+
+        assert!(umbrella.contains("#include \"client.dll/C_Base.hpp\"\n"));
+        assert!(umbrella.contains("#include \"client.dll/C_Removed.hpp\"\n"));
+
+        let base = file_path.join("C_Base.hpp");
+
+        assert!(fs::read_to_string(&base)?
+            .contains("namespace C_Base {\n    constexpr std::ptrdiff_t m_iHealth = 0x10;\n}\n"));
+
+        // Backdate the header so that a rewrite would be visible.
+        let backdated = SystemTime::UNIX_EPOCH + Duration::from_secs(1_000_000_000);
+
+        fs::File::options()
+            .write(true)
+            .open(&base)?
+            .set_modified(backdated)?;
+
+        let umbrella = render(&["C_Base"])?;
+
+        assert!(!umbrella.contains("C_Removed"));
+        assert!(!file_path.join("C_Removed.hpp").exists());
+        assert_eq!(fs::metadata(&base)?.modified()?, backdated);
+
+        fs::remove_dir_all(&root)?;
 
         Ok(())
     }
@@ -0,0 +1,113 @@
+use std::io::{Result, Write};
+use std::path::Path;
+
+use super::{file_name, FileBuilder};
+
+/// Writes a C++20 module interface unit (`export module cs2.client;`) with the same namespaces
+/// and constants as `CppFileBuilder`.
+#[derive(Debug, Default, PartialEq)]
+pub struct CppModuleFileBuilder;
+
+impl FileBuilder for CppModuleFileBuilder {
+    fn extension(&mut self) -> &str {
+        "cppm"
+    }
+
+    fn write_top_level(&mut self, output: &mut dyn Write, file_path: &Path) -> Result<()> {
+        write!(output, "module;\n\n")?;
+        write!(output, "#include <cstddef>\n\n")?;
+        write!(
+            output,
+            "export module {};\n\n",
+            module_name(&file_name(file_path))
+        )?;
+
+        Ok(())
+    }
+
+    fn write_namespace(&mut self, output: &mut dyn Write, name: &str) -> Result<()> {
+        write!(output, "export namespace {} {{\n", name)?;
+
+        Ok(())
+    }
+
+    fn write_variable(
+        &mut self,
+        output: &mut dyn Write,
+        name: &str,
+        value: usize,
+        comment: Option<&str>,
+    ) -> Result<()> {
+        match comment {
+            Some(comment) => write!(
+                output,
+                "    inline constexpr std::ptrdiff_t {} = {:#X}; // {}\n",
+                name, value, comment
+            ),
+            None => write!(
+                output,
+                "    inline constexpr std::ptrdiff_t {} = {:#X};\n",
+                name, value
+            ),
+        }
+    }
+
+    fn write_closure(&mut self, output: &mut dyn Write, eof: bool) -> Result<()> {
+        write!(output, "{}", if eof { "}" } else { "}\n\n" })?;
+
+        Ok(())
+    }
+}
+
+/// Returns the module name for an output file, e.g. `cs2.client` for `client.dll`.
+fn module_name(file_name: &str) -> String {
+    let name: String = file_name
+        .trim_end_matches(".dll")
+        .chars()
+        .map(|c| if c.is_ascii_alphanumeric() { c } else { '_' })
+        .collect();
+
+    format!("cs2.{}", name)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn render_module() -> Result<()> {
+        let mut builder = CppModuleFileBuilder;
+        let mut output = Vec::new();
+
+        builder.write_top_level(&mut output, Path::new("generated/client.dll"))?;
+        builder.write_namespace(&mut output, "C_BaseEntity")?;
+        builder.write_variable(&mut output, "m_iHealth", 0x344, Some("int32"))?;
+        builder.write_closure(&mut output, false)?;
+        builder.write_namespace(&mut output, "C_BasePlayerPawn")?;
+        builder.write_variable(&mut output, "m_pWeaponServices", 0x10F8, None)?;
+        builder.write_closure(&mut output, true)?;
+
+        assert_eq!(
+            String::from_utf8(output).unwrap(),
+            "module;
+
+#include <cstddef>
+
+export module cs2.client;
+
+export namespace C_BaseEntity {
+    inline constexpr std::ptrdiff_t m_iHealth = 0x344; // int32
+}
+
+export namespace C_BasePlayerPawn {
+    inline constexpr std::ptrdiff_t m_pWeaponServices = 0x10F8;
+}"
+        );
+
+        assert_eq!(module_name("animationsystem.dll"), "cs2.animationsystem");
+        assert_eq!(module_name("offsets"), "cs2.offsets");
+        assert_eq!(module_name("engine2-x64.dll"), "cs2.engine2_x64");
+
+        Ok(())
+    }
+}
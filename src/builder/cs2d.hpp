@@ -0,0 +1,160 @@
+// Header-only reader for .cs2d files written by https://github.com/a2x/cs2-dumper
+//
+// Layout (little-endian, all offsets from the start of the file):
+//
+//     Header     magic "CS2D", version, entry/bucket/type counts and section offsets
+//     seeds      one uint32_t per bucket
+//     entries    Entry[entry_count], placed by a minimal perfect hash of their key
+//     types      TypeName[type_count]
+//     strings    key and type name bytes, not null-terminated
+//
+// Keys are "file::namespace::name", e.g. "client.dll::C_BaseEntity::m_iHealth". A lookup hashes
+// the key with seed 0 to pick a bucket, hashes it again with that bucket's seed to pick an entry
+// and compares the entry's key, so unknown keys are rejected.
+//
+// The reader does not copy or parse anything, point it at a memory-mapped file:
+//
+//     cs2d::Reader reader(view, size);
+//
+//     if (const auto* entry = reader.find("client.dll::C_BaseEntity::m_iHealth"))
+//         health_offset = entry->value;
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace cs2d {
+    constexpr std::uint32_t magic = 0x44325343; // "CS2D"
+    constexpr std::uint32_t version = 1;
+    constexpr std::uint32_t no_type = 0xFFFFFFFF;
+
+    struct Header {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t entry_count;
+        std::uint32_t bucket_count;
+        std::uint32_t type_count;
+        std::uint32_t seeds_offset;
+        std::uint32_t entries_offset;
+        std::uint32_t types_offset;
+        std::uint32_t strings_offset;
+    };
+
+    struct Entry {
+        std::uint32_t key_offset;
+        std::uint32_t key_length;
+        std::uint64_t value;
+        std::uint32_t type_id;
+        std::uint32_t reserved;
+    };
+
+    struct TypeName {
+        std::uint32_t offset;
+        std::uint32_t length;
+    };
+
+    static_assert(sizeof(Header) == 36);
+    static_assert(sizeof(Entry) == 24);
+    static_assert(sizeof(TypeName) == 8);
+
+    constexpr std::uint64_t hash(std::string_view key, std::uint32_t seed) noexcept {
+        std::uint64_t hash = 0xCBF29CE484222325ull ^ (seed * 0x9E3779B97F4A7C15ull);
+
+        for (const char c : key) {
+            hash ^= static_cast<std::uint8_t>(c);
+            hash *= 0x100000001B3ull;
+        }
+
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 33;
+        hash *= 0xC4CEB9FE1A85EC53ull;
+        hash ^= hash >> 33;
+
+        return hash;
+    }
+
+    class Reader {
+    public:
+        Reader(const void* data, std::size_t size) noexcept
+            : data_(static_cast<const std::uint8_t*>(data)), size_(size) {
+            if (size_ < sizeof(Header))
+                return;
+
+            std::memcpy(&header_, data_, sizeof(Header));
+
+            valid_ = header_.magic == magic && header_.version == version &&
+                     fits(header_.seeds_offset, std::uint64_t(header_.bucket_count) * 4) &&
+                     fits(header_.entries_offset, std::uint64_t(header_.entry_count) * sizeof(Entry)) &&
+                     fits(header_.types_offset, std::uint64_t(header_.type_count) * sizeof(TypeName)) &&
+                     header_.strings_offset <= size_ && header_.entries_offset % alignof(Entry) == 0 &&
+                     (header_.entry_count == 0 || header_.bucket_count != 0);
+        }
+
+        bool valid() const noexcept {
+            return valid_;
+        }
+
+        std::size_t size() const noexcept {
+            return valid_ ? header_.entry_count : 0;
+        }
+
+        const Entry* begin() const noexcept {
+            return reinterpret_cast<const Entry*>(data_ + header_.entries_offset);
+        }
+
+        const Entry* end() const noexcept {
+            return begin() + size();
+        }
+
+        const Entry* find(std::string_view key) const noexcept {
+            if (!valid_ || header_.entry_count == 0)
+                return nullptr;
+
+            std::uint32_t seed;
+
+            std::memcpy(&seed, data_ + header_.seeds_offset + (hash(key, 0) % header_.bucket_count) * 4, 4);
+
+            const Entry* entry = begin() + hash(key, seed) % header_.entry_count;
+
+            return this->key(*entry) == key ? entry : nullptr;
+        }
+
+        std::string_view key(const Entry& entry) const noexcept {
+            return string(entry.key_offset, entry.key_length);
+        }
+
+        std::string_view type_name(const Entry& entry) const noexcept {
+            if (entry.type_id == no_type || entry.type_id >= header_.type_count)
+                return {};
+
+            TypeName type;
+
+            std::memcpy(&type, data_ + header_.types_offset + entry.type_id * sizeof(TypeName), sizeof(TypeName));
+
+            return string(type.offset, type.length);
+        }
+
+    private:
+        bool fits(std::uint64_t offset, std::uint64_t length) const noexcept {
+            return offset <= size_ && length <= size_ - offset;
+        }
+
+        std::string_view string(std::uint32_t offset, std::uint32_t length) const noexcept {
+            const std::uint64_t start = std::uint64_t(header_.strings_offset) + offset;
+
+            if (!fits(start, length))
+                return {};
+
+            return {reinterpret_cast<const char*>(data_ + start), length};
+        }
+
+        const std::uint8_t* data_ = nullptr;
+        std::size_t size_ = 0;
+        Header header_ = {};
+        bool valid_ = false;
+    };
+}
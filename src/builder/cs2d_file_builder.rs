@@ -0,0 +1,322 @@
+use std::collections::{HashMap, HashSet};
+use std::io::{Result, Write};
+use std::path::Path;
+
+use super::{file_name, FileBuilder};
+
+pub const CS2D_MAGIC: &[u8; 4] = b"CS2D";
+pub const CS2D_VERSION: u32 = 1;
+
+/// Header-only C++ reader for `.cs2d` files, written next to the generated headers.
+pub const CS2D_READER: &str = include_str!("cs2d.hpp");
+
+/// Type ID of entries written without a type name.
+pub const NO_TYPE: u32 = u32::MAX;
+
+const HEADER_SIZE: usize = 9 * 4;
+const ENTRY_SIZE: usize = 24;
+
+const FNV_OFFSET_BASIS: u64 = 0xCBF29CE484222325;
+const FNV_PRIME: u64 = 0x100000001B3;
+
+/// Writes a binary `.cs2d` file that can be memory-mapped and queried without parsing.
+///
+/// Entries are keyed by `file::namespace::name` and placed with a minimal perfect hash (hash and
+/// displace), so a lookup hashes the key twice and compares it against a single entry. See
+/// `cs2d.hpp` for the layout.
+#[derive(Debug, Default, PartialEq)]
+pub struct Cs2dFileBuilder {
+    file_name: String,
+    namespace: String,
+    entries: Vec<(String, u64, Option<String>)>,
+}
+
+impl FileBuilder for Cs2dFileBuilder {
+    fn extension(&mut self) -> &str {
+        "cs2d"
+    }
+
+    fn write_top_level(&mut self, _output: &mut dyn Write, file_path: &Path) -> Result<()> {
+        self.file_name = file_name(file_path);
+
+        Ok(())
+    }
+
+    fn write_namespace(&mut self, _output: &mut dyn Write, name: &str) -> Result<()> {
+        self.namespace = name.to_string();
+
+        Ok(())
+    }
+
+    fn write_variable(
+        &mut self,
+        _output: &mut dyn Write,
+        name: &str,
+        value: usize,
+        comment: Option<&str>,
+    ) -> Result<()> {
+        self.entries.push((
+            format!("{}::{}::{}", self.file_name, self.namespace, name),
+            value as u64,
+            comment.map(str::to_string),
+        ));
+
+        Ok(())
+    }
+
+    fn write_closure(&mut self, output: &mut dyn Write, eof: bool) -> Result<()> {
+        if eof {
+            output.write_all(&build(&self.entries))?;
+
+            self.entries.clear();
+        }
+
+        Ok(())
+    }
+}
+
+/// FNV-1a over `key` with `seed` folded into the basis, finished with the MurmurHash3 mixer so
+/// the low bits are usable as a table index.
+pub fn hash(key: &[u8], seed: u32) -> u64 {
+    let mut hash = FNV_OFFSET_BASIS ^ (seed as u64).wrapping_mul(0x9E3779B97F4A7C15);
+
+    for &byte in key {
+        hash ^= byte as u64;
+        hash = hash.wrapping_mul(FNV_PRIME);
+    }
+
+    hash ^= hash >> 33;
+    hash = hash.wrapping_mul(0xFF51AFD7ED558CCD);
+    hash ^= hash >> 33;
+    hash = hash.wrapping_mul(0xC4CEB9FE1A85EC53);
+    hash ^= hash >> 33;
+
+    hash
+}
+
+/// Builds a minimal perfect hash over `keys`.
+///
+/// Keys are grouped into buckets by `hash(key, 0)`. Buckets are placed largest first, each one
+/// searching for the first seed that sends all of its keys to free slots. Returns the seed of
+/// every bucket and the slot of every key.
+pub fn build_perfect_hash(keys: &[&[u8]]) -> (Vec<u32>, Vec<usize>) {
+    let bucket_count = (keys.len() / 2).max(1);
+
+    let mut buckets: Vec<Vec<usize>> = vec![Vec::new(); bucket_count];
+
+    for (index, key) in keys.iter().enumerate() {
+        buckets[(hash(key, 0) % bucket_count as u64) as usize].push(index);
+    }
+
+    let mut order: Vec<usize> = (0..bucket_count).collect();
+
+    order.sort_by_key(|&bucket| std::cmp::Reverse(buckets[bucket].len()));
+
+    let mut seeds = vec![0u32; bucket_count];
+    let mut slots = vec![0usize; keys.len()];
+    let mut taken = vec![false; keys.len()];
+
+    let mut candidate: Vec<usize> = Vec::new();
+
+    for bucket in order {
+        if buckets[bucket].is_empty() {
+            break;
+        }
+
+        for seed in 1.. {
+            candidate.clear();
+
+            let fits = buckets[bucket].iter().all(|&index| {
+                let slot = (hash(keys[index], seed) % keys.len() as u64) as usize;
+
+                let free = !taken[slot] && !candidate.contains(&slot);
+
+                candidate.push(slot);
+
+                free
+            });
+
+            if fits {
+                for (&index, &slot) in buckets[bucket].iter().zip(&candidate) {
+                    taken[slot] = true;
+                    slots[index] = slot;
+                }
+
+                seeds[bucket] = seed;
+
+                break;
+            }
+        }
+    }
+
+    (seeds, slots)
+}
+
+/// Appends `value` to the string pool and returns its offset and length.
+fn push_string(strings: &mut Vec<u8>, value: &str) -> (u32, u32) {
+    let offset = strings.len() as u32;
+
+    strings.extend_from_slice(value.as_bytes());
+
+    (offset, value.len() as u32)
+}
+
+fn build(entries: &[(String, u64, Option<String>)]) -> Vec<u8> {
+    // Keys have to be unique for the perfect hash, the first entry with a given key wins.
+    let mut seen: HashSet<&str> = HashSet::new();
+
+    let entries: Vec<_> = entries
+        .iter()
+        .filter(|(key, _, _)| seen.insert(key))
+        .collect();
+
+    let mut strings: Vec<u8> = Vec::new();
+
+    let mut type_ids: HashMap<&str, u32> = HashMap::new();
+    let mut types: Vec<(u32, u32)> = Vec::new();
+
+    let records: Vec<_> = entries
+        .iter()
+        .map(|(key, value, type_name)| {
+            let type_id = match type_name {
+                Some(type_name) => *type_ids.entry(type_name).or_insert_with(|| {
+                    types.push(push_string(&mut strings, type_name));
+
+                    (types.len() - 1) as u32
+                }),
+                None => NO_TYPE,
+            };
+
+            (push_string(&mut strings, key), *value, type_id)
+        })
+        .collect();
+
+    let keys: Vec<&[u8]> = entries.iter().map(|(key, _, _)| key.as_bytes()).collect();
+
+    let (seeds, slots) = build_perfect_hash(&keys);
+
+    let seeds_offset = HEADER_SIZE;
+    let entries_offset = (seeds_offset + seeds.len() * 4 + 7) & !7;
+    let types_offset = entries_offset + records.len() * ENTRY_SIZE;
+    let strings_offset = types_offset + types.len() * 8;
+
+    let mut data = vec![0u8; strings_offset + strings.len()];
+
+    let header = [
+        u32::from_le_bytes(*CS2D_MAGIC),
+        CS2D_VERSION,
+        records.len() as u32,
+        seeds.len() as u32,
+        types.len() as u32,
+        seeds_offset as u32,
+        entries_offset as u32,
+        types_offset as u32,
+        strings_offset as u32,
+    ];
+
+    for (i, value) in header.iter().enumerate() {
+        data[i * 4..i * 4 + 4].copy_from_slice(&value.to_le_bytes());
+    }
+
+    for (i, seed) in seeds.iter().enumerate() {
+        let offset = seeds_offset + i * 4;
+
+        data[offset..offset + 4].copy_from_slice(&seed.to_le_bytes());
+    }
+
+    for (&((key_offset, key_len), value, type_id), slot) in records.iter().zip(slots) {
+        let offset = entries_offset + slot * ENTRY_SIZE;
+
+        data[offset..offset + 4].copy_from_slice(&key_offset.to_le_bytes());
+        data[offset + 4..offset + 8].copy_from_slice(&key_len.to_le_bytes());
+        data[offset + 8..offset + 16].copy_from_slice(&value.to_le_bytes());
+        data[offset + 16..offset + 20].copy_from_slice(&type_id.to_le_bytes());
+    }
+
+    for (i, (name_offset, name_len)) in types.iter().enumerate() {
+        let offset = types_offset + i * 8;
+
+        data[offset..offset + 4].copy_from_slice(&name_offset.to_le_bytes());
+        data[offset + 4..offset + 8].copy_from_slice(&name_len.to_le_bytes());
+    }
+
+    data[strings_offset..].copy_from_slice(&strings);
+
+    data
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    use crate::mem::ByteReader;
+
+    /// Mirrors `cs2d::Reader::find`.
+    fn find(data: &[u8], key: &str) -> Option<(u64, u32)> {
+        let header: Vec<u32> = data[..HEADER_SIZE]
+            .chunks(4)
+            .map(|bytes| u32::from_le_bytes(bytes.try_into().unwrap()))
+            .collect();
+
+        let (entry_count, bucket_count) = (header[2] as u64, header[3] as u64);
+
+        let bucket = (hash(key.as_bytes(), 0) % bucket_count) as usize;
+
+        let mut reader = ByteReader::new(data);
+
+        reader.position = header[5] as usize + bucket * 4;
+
+        let seed = reader.u32().unwrap();
+
+        reader.position =
+            header[6] as usize + (hash(key.as_bytes(), seed) % entry_count) as usize * ENTRY_SIZE;
+
+        let key_offset = reader.u32().unwrap() as usize + header[8] as usize;
+        let key_len = reader.u32().unwrap() as usize;
+
+        let value = reader.u64().unwrap();
+        let type_id = reader.u32().unwrap();
+
+        (&data[key_offset..key_offset + key_len] == key.as_bytes()).then_some((value, type_id))
+    }
+
+    #[test]
+    fn lookup() -> Result<()> {
+        let mut builder = Cs2dFileBuilder::default();
+        let mut output = Vec::new();
+
+        builder.write_top_level(&mut output, Path::new("client.dll"))?;
+
+        for class in 0..100 {
+            builder.write_namespace(&mut output, &format!("C_Class{}", class))?;
+
+            for field in 0..50 {
+                let type_name = format!("Type{}", field % 7);
+
+                builder.write_variable(
+                    &mut output,
+                    &format!("m_field{}", field),
+                    class * 0x1000 + field * 8,
+                    Some(&type_name),
+                )?;
+            }
+
+            builder.write_closure(&mut output, class == 99)?;
+        }
+
+        for class in 0..100 {
+            for field in 0..50 {
+                let key = format!("client.dll::C_Class{}::m_field{}", class, field);
+
+                assert_eq!(
+                    find(&output, &key),
+                    Some(((class * 0x1000 + field * 8) as u64, (field % 7) as u32))
+                );
+            }
+        }
+
+        assert_eq!(find(&output, "client.dll::C_Class0::m_missing"), None);
+
+        Ok(())
+    }
+}
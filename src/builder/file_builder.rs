@@ -1,9 +1,13 @@
 use std::io::{Result, Write};
+use std::path::Path;
+
+use super::ClassLayout;
 
 pub trait FileBuilder {
     fn extension(&mut self) -> &str;
 
-    fn write_top_level(&mut self, output: &mut dyn Write) -> Result<()>;
+    /// `file_path` is the path of the output file without its extension.
+    fn write_top_level(&mut self, output: &mut dyn Write, file_path: &Path) -> Result<()>;
 
     fn write_namespace(&mut self, output: &mut dyn Write, name: &str) -> Result<()>;
 
@@ -15,5 +19,10 @@ pub trait FileBuilder {
         comment: Option<&str>,
     ) -> Result<()>;
 
+    /// Called after the variables of a namespace that describes a class with a known layout.
+    fn write_layout(&mut self, _output: &mut dyn Write, _layout: &ClassLayout) -> Result<()> {
+        Ok(())
+    }
+
     fn write_closure(&mut self, output: &mut dyn Write, eof: bool) -> Result<()>;
 }
@@ -1,13 +1,15 @@
 use std::io::{Result, Write};
+use std::path::Path;
 
 use serde_json::{json, Map, Value};
 
-use super::FileBuilder;
+use super::{ClassLayout, FileBuilder};
 
 #[derive(Debug, PartialEq)]
 pub struct JsonFileBuilder {
     json: Value,
     namespace: String,
+    read_spans: Map<String, Value>,
 }
 
 impl Default for JsonFileBuilder {
@@ -15,6 +17,7 @@ impl Default for JsonFileBuilder {
         Self {
             json: Value::Object(Map::new()),
             namespace: String::new(),
+            read_spans: Map::new(),
         }
     }
 }
@@ -24,7 +27,7 @@ impl FileBuilder for JsonFileBuilder {
         "json"
     }
 
-    fn write_top_level(&mut self, _output: &mut dyn Write) -> Result<()> {
+    fn write_top_level(&mut self, _output: &mut dyn Write, _file_path: &Path) -> Result<()> {
         Ok(())
     }
 
@@ -52,8 +55,36 @@ impl FileBuilder for JsonFileBuilder {
         Ok(())
     }
 
+    fn write_layout(&mut self, _output: &mut dyn Write, layout: &ClassLayout) -> Result<()> {
+        if layout.read_spans.is_empty() {
+            return Ok(());
+        }
+
+        let read_spans: Vec<Value> = layout
+            .read_spans
+            .iter()
+            .map(|span| json!([span.offset, span.size]))
+            .collect();
+
+        // Classes stay plain name-to-offset maps, the spans of every class are collected into a
+        // separate top-level object.
+        self.read_spans
+            .insert(self.namespace.clone(), Value::Array(read_spans));
+
+        Ok(())
+    }
+
     fn write_closure(&mut self, output: &mut dyn Write, eof: bool) -> Result<()> {
         if eof {
+            if !self.read_spans.is_empty() {
+                if let Some(map) = self.json.as_object_mut() {
+                    map.insert(
+                        "read_spans".to_string(),
+                        Value::Object(std::mem::take(&mut self.read_spans)),
+                    );
+                }
+            }
+
             write!(output, "{}", serde_json::to_string_pretty(&self.json)?)?;
 
             self.json = json!({});
@@ -62,3 +93,38 @@ impl FileBuilder for JsonFileBuilder {
         Ok(())
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    use crate::builder::class_layout::ReadSpan;
+
+    #[test]
+    fn read_spans_are_kept_apart_from_fields() -> Result<()> {
+        let mut builder = JsonFileBuilder::default();
+
+        let mut output = Vec::new();
+
+        let layout = ClassLayout {
+            read_spans: vec![ReadSpan {
+                offset: 0x10,
+                size: 0x8,
+                fields: vec!["read_spans".to_string()],
+            }],
+            ..Default::default()
+        };
+
+        builder.write_namespace(&mut output, "C_Example")?;
+        builder.write_variable(&mut output, "read_spans", 0x10, None)?;
+        builder.write_layout(&mut output, &layout)?;
+        builder.write_closure(&mut output, true)?;
+
+        let json: Value = serde_json::from_slice(&output)?;
+
+        assert_eq!(json["C_Example"], json!({ "read_spans": 0x10 }));
+        assert_eq!(json["read_spans"], json!({ "C_Example": [[0x10, 0x8]] }));
+
+        Ok(())
+    }
+}
@@ -1,12 +1,19 @@
 pub use std::io::{Result, Write};
+use std::path::Path;
 
-pub use cpp_file_builder::CppFileBuilder;
+pub use class_layout::{ClassLayout, ClassLayouts, FieldLayout};
+pub use cpp_file_builder::{CppFileBuilder, CppFileBuilderOptions};
+pub use cpp_module_file_builder::CppModuleFileBuilder;
+pub use cs2d_file_builder::Cs2dFileBuilder;
 pub use csharp_file_builder::CSharpFileBuilder;
 pub use file_builder::FileBuilder;
 pub use json_file_builder::JsonFileBuilder;
 pub use rust_file_builder::RustFileBuilder;
 
+pub mod class_layout;
 pub mod cpp_file_builder;
+pub mod cpp_module_file_builder;
+pub mod cs2d_file_builder;
 pub mod csharp_file_builder;
 pub mod file_builder;
 pub mod json_file_builder;
@@ -15,6 +22,8 @@ pub mod rust_file_builder;
 #[derive(Debug, PartialEq)]
 pub enum FileBuilderEnum {
     CppFileBuilder(CppFileBuilder),
+    CppModuleFileBuilder(CppModuleFileBuilder),
+    Cs2dFileBuilder(Cs2dFileBuilder),
     CSharpFileBuilder(CSharpFileBuilder),
     JsonFileBuilder(JsonFileBuilder),
     RustFileBuilder(RustFileBuilder),
@@ -25,8 +34,8 @@ impl FileBuilder for FileBuilderEnum {
         self.as_mut().extension()
     }
 
-    fn write_top_level(&mut self, output: &mut dyn Write) -> Result<()> {
-        self.as_mut().write_top_level(output)
+    fn write_top_level(&mut self, output: &mut dyn Write, file_path: &Path) -> Result<()> {
+        self.as_mut().write_top_level(output, file_path)
     }
 
     fn write_namespace(&mut self, output: &mut dyn Write, name: &str) -> Result<()> {
@@ -43,15 +52,29 @@ impl FileBuilder for FileBuilderEnum {
         self.as_mut().write_variable(output, name, value, comment)
     }
 
+    fn write_layout(&mut self, output: &mut dyn Write, layout: &ClassLayout) -> Result<()> {
+        self.as_mut().write_layout(output, layout)
+    }
+
     fn write_closure(&mut self, output: &mut dyn Write, eof: bool) -> Result<()> {
         self.as_mut().write_closure(output, eof)
     }
 }
 
+/// Returns the file name component of an output path, e.g. `client.dll`.
+pub fn file_name(file_path: &Path) -> String {
+    file_path
+        .file_name()
+        .map(|name| name.to_string_lossy().into_owned())
+        .unwrap_or_default()
+}
+
 impl FileBuilderEnum {
     fn as_mut(&mut self) -> &mut dyn FileBuilder {
         match self {
             FileBuilderEnum::CppFileBuilder(builder) => builder,
+            FileBuilderEnum::CppModuleFileBuilder(builder) => builder,
+            FileBuilderEnum::Cs2dFileBuilder(builder) => builder,
             FileBuilderEnum::CSharpFileBuilder(builder) => builder,
             FileBuilderEnum::JsonFileBuilder(builder) => builder,
             FileBuilderEnum::RustFileBuilder(builder) => builder,
@@ -1,4 +1,5 @@
 use std::io::{Result, Write};
+use std::path::Path;
 
 use super::FileBuilder;
 
@@ -10,7 +11,7 @@ impl FileBuilder for RustFileBuilder {
         "rs"
     }
 
-    fn write_top_level(&mut self, output: &mut dyn Write) -> Result<()> {
+    fn write_top_level(&mut self, output: &mut dyn Write, _file_path: &Path) -> Result<()> {
         write!(
             output,
             "#![allow(non_snake_case, non_upper_case_globals)]\n\n"
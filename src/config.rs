@@ -1,5 +1,7 @@
 use serde::{Deserialize, Serialize};
 
+use crate::mem::Pattern;
+
 #[derive(Debug, Deserialize, Serialize)]
 #[serde(tag = "type", rename_all = "camelCase")]
 pub enum Operation {
@@ -14,6 +16,13 @@ pub enum Operation {
         offset: Option<usize>,
         length: Option<usize>,
     },
+    /// Moves to the nearest match of `pattern` that starts within `range` bytes after the
+    /// address, or before it if `backward` is set. The pattern is parsed with the config.
+    NearScan {
+        pattern: Pattern,
+        range: usize,
+        backward: Option<bool>,
+    },
     RipRelative {
         offset: Option<usize>,
         length: Option<usize>,
@@ -31,7 +40,12 @@ pub enum Operation {
 pub struct Signature {
     pub name: String,
     pub module: String,
-    pub pattern: String,
+    /// Scanned for in the whole module, or only after `base` if that is set.
+    pub pattern: Option<String>,
+    /// Name of another signature whose resolved address this one starts from.
+    pub base: Option<String>,
+    /// Number of bytes after `base` searched for `pattern`.
+    pub window: Option<usize>,
     pub operations: Vec<Operation>,
 }
 
@@ -0,0 +1,571 @@
+//! Measures how long the host C++ compiler takes to compile the generated headers under each
+//! `CppFileBuilder` mode and the C++20 module interfaces, and how much memory it needs.
+//!
+//! Run with `cargo test --release compile_generated_headers -- --ignored --nocapture`.
+//! `compile_cs2d_reader` also builds a program against `cs2d.hpp` and runs lookups through it.
+//!
+//! - `CS2_SCHEMA_CACHE` renders a cache written with `--save-schemas` instead of a mock schema
+//!   system.
+//! - `CXX` selects the compiler (`c++` by default, `cl` on Windows).
+//! - `CS2_COMPILE_REPORT` sets where the JSON report is written (`compile_benchmark.json` in
+//!   `CARGO_TARGET_DIR` or `target` by default).
+
+use std::env;
+use std::fs::{self, File};
+use std::io;
+use std::path::{Path, PathBuf};
+use std::process::{Child, Command, Stdio};
+use std::time::{Duration, Instant};
+
+use serde_json::{json, Value};
+
+use crate::builder::cs2d_file_builder::CS2D_READER;
+use crate::builder::{
+    CppFileBuilder, CppFileBuilderOptions, CppModuleFileBuilder, Cs2dFileBuilder, FileBuilderEnum,
+    JsonFileBuilder,
+};
+use crate::error::Result;
+use crate::remote::Process;
+use crate::schema::SchemaDatabase;
+use crate::sdk::mock_schema_system::MockSchemaSystem;
+use crate::session::Session;
+
+use super::dump_schemas;
+
+/// Removes a directory and everything in it when dropped, so failed runs clean up too.
+struct TempDir(PathBuf);
+
+impl Drop for TempDir {
+    fn drop(&mut self) {
+        let _ = fs::remove_dir_all(&self.0);
+    }
+}
+
+/// The `CppFileBuilder` modes, and `None` for the C++20 module interfaces.
+const MODES: &[(&str, Option<CppFileBuilderOptions>)] = &[
+    (
+        "monolithic",
+        Some(CppFileBuilderOptions {
+            lookup_tables: false,
+            structs: false,
+            typed_fields: false,
+            split_headers: false,
+        }),
+    ),
+    (
+        "split_headers",
+        Some(CppFileBuilderOptions {
+            lookup_tables: false,
+            structs: false,
+            typed_fields: false,
+            split_headers: true,
+        }),
+    ),
+    (
+        "lookup_tables",
+        Some(CppFileBuilderOptions {
+            lookup_tables: true,
+            structs: false,
+            typed_fields: false,
+            split_headers: false,
+        }),
+    ),
+    (
+        "structs",
+        Some(CppFileBuilderOptions {
+            lookup_tables: false,
+            structs: true,
+            typed_fields: false,
+            split_headers: false,
+        }),
+    ),
+    (
+        "typed_fields",
+        Some(CppFileBuilderOptions {
+            lookup_tables: false,
+            structs: false,
+            typed_fields: true,
+            split_headers: false,
+        }),
+    ),
+    ("cpp_module", None),
+];
+
+struct Measurement {
+    duration: Duration,
+    peak_memory: Option<u64>,
+}
+
+#[derive(Clone, Copy, PartialEq)]
+enum CompilerKind {
+    Gcc,
+    Clang,
+    Msvc,
+}
+
+/// How a generated file is handed to the compiler.
+#[derive(Clone, Copy, PartialEq)]
+enum Unit {
+    /// A header, included from a C++17 translation unit of its own.
+    Header,
+    /// A C++20 module interface unit, compiled directly.
+    ModuleInterface,
+    /// A C++17 source file, compiled and linked into an executable.
+    Program,
+}
+
+impl Unit {
+    fn extension(self) -> &'static str {
+        match self {
+            Unit::Header => "hpp",
+            Unit::ModuleInterface => "cppm",
+            Unit::Program => "cpp",
+        }
+    }
+}
+
+fn compiler() -> String {
+    env::var("CXX").unwrap_or_else(|_| if cfg!(windows) { "cl" } else { "c++" }.to_string())
+}
+
+fn compiler_kind(compiler: &str) -> CompilerKind {
+    let is_msvc = Path::new(compiler)
+        .file_stem()
+        .map_or(false, |stem| stem == "cl" || stem == "clang-cl");
+
+    if is_msvc {
+        return CompilerKind::Msvc;
+    }
+
+    // `c++` may be either, so ask the compiler itself.
+    let is_clang = Command::new(compiler)
+        .arg("--version")
+        .output()
+        .map_or(false, |output| {
+            String::from_utf8_lossy(&output.stdout).contains("clang")
+        });
+
+    if is_clang {
+        CompilerKind::Clang
+    } else {
+        CompilerKind::Gcc
+    }
+}
+
+fn compile(compiler: &str, source: &Path, unit: Unit) -> io::Result<Measurement> {
+    let kind = compiler_kind(compiler);
+
+    let object = match (kind, unit) {
+        (_, Unit::Program) => source.with_extension(env::consts::EXE_EXTENSION),
+        (CompilerKind::Msvc, _) => source.with_extension("obj"),
+        _ => source.with_extension("o"),
+    };
+
+    let mut command = Command::new(compiler);
+
+    // GCC writes compiled module interfaces to `gcm.cache` in the working directory.
+    if let Some(dir) = source.parent() {
+        command.current_dir(dir);
+    }
+
+    match (kind, unit) {
+        (CompilerKind::Msvc, Unit::Header) => {
+            command.args(["/nologo", "/std:c++17", "/c"]);
+        }
+        (CompilerKind::Msvc, Unit::ModuleInterface) => {
+            command.args(["/nologo", "/std:c++20", "/interface", "/c"]);
+        }
+        (CompilerKind::Msvc, Unit::Program) => {
+            command.args(["/nologo", "/std:c++17", "/EHsc"]);
+        }
+        (_, Unit::Header) => {
+            command.args(["-std=c++17", "-c"]);
+        }
+        (_, Unit::Program) => {
+            command.arg("-std=c++17");
+        }
+        (CompilerKind::Clang, Unit::ModuleInterface) => {
+            command.args(["-std=c++20", "-x", "c++-module", "-c"]);
+        }
+        (CompilerKind::Gcc, Unit::ModuleInterface) => {
+            command.args(["-std=c++20", "-fmodules-ts", "-x", "c++", "-c"]);
+        }
+    }
+
+    command.arg(source);
+
+    if kind == CompilerKind::Msvc {
+        let flag = if unit == Unit::Program { "/Fe" } else { "/Fo" };
+
+        command.arg(format!("{}{}", flag, object.display()));
+    } else {
+        command.arg("-o").arg(&object);
+    }
+
+    let log_path = source.with_extension("log");
+
+    command
+        .stdout(Stdio::from(File::create(&log_path)?))
+        .stderr(Stdio::from(File::create(&log_path)?));
+
+    let start_time = Instant::now();
+
+    let (success, peak_memory) = wait_with_peak_memory(command.spawn()?)?;
+
+    let duration = start_time.elapsed();
+
+    if !success {
+        return Err(io::Error::new(
+            io::ErrorKind::Other,
+            format!(
+                "failed to compile {}:\n{}",
+                source.display(),
+                fs::read_to_string(&log_path).unwrap_or_default()
+            ),
+        ));
+    }
+
+    Ok(Measurement {
+        duration,
+        peak_memory,
+    })
+}
+
+/// Waits for `child` and returns whether it succeeded along with the peak resident memory of it
+/// and the processes it waited for, in bytes.
+#[cfg(target_os = "linux")]
+fn wait_with_peak_memory(child: Child) -> io::Result<(bool, Option<u64>)> {
+    #[repr(C)]
+    struct Rusage {
+        utime: [i64; 2],
+        stime: [i64; 2],
+        maxrss: i64,
+        other: [i64; 13],
+    }
+
+    extern "C" {
+        fn wait4(pid: i32, status: *mut i32, options: i32, rusage: *mut Rusage) -> i32;
+    }
+
+    let mut status = 0;
+    let mut rusage: Rusage = unsafe { std::mem::zeroed() };
+
+    if unsafe { wait4(child.id() as i32, &mut status, 0, &mut rusage) } < 0 {
+        return Err(io::Error::last_os_error());
+    }
+
+    let success = status & 0x7F == 0 && (status >> 8) & 0xFF == 0;
+
+    // `ru_maxrss` is in kilobytes and already covers the compiler driver's children.
+    Ok((success, Some(rusage.maxrss as u64 * 1024)))
+}
+
+#[cfg(windows)]
+fn wait_with_peak_memory(mut child: Child) -> io::Result<(bool, Option<u64>)> {
+    use std::os::windows::io::AsRawHandle;
+
+    use windows::Win32::Foundation::HANDLE;
+    use windows::Win32::System::ProcessStatus::{GetProcessMemoryInfo, PROCESS_MEMORY_COUNTERS};
+
+    let status = child.wait()?;
+
+    let mut counters = PROCESS_MEMORY_COUNTERS::default();
+
+    let _ = unsafe {
+        GetProcessMemoryInfo(
+            HANDLE(child.as_raw_handle() as isize),
+            &mut counters,
+            std::mem::size_of::<PROCESS_MEMORY_COUNTERS>() as u32,
+        )
+    };
+
+    let peak_memory = counters.PeakWorkingSetSize as u64;
+
+    Ok((status.success(), (peak_memory != 0).then_some(peak_memory)))
+}
+
+#[cfg(not(any(target_os = "linux", windows)))]
+fn wait_with_peak_memory(mut child: Child) -> io::Result<(bool, Option<u64>)> {
+    Ok((child.wait()?.success(), None))
+}
+
+fn file_bytes(dir: &Path, extension: &str) -> io::Result<u64> {
+    let mut bytes = 0;
+
+    for entry in fs::read_dir(dir)? {
+        let entry = entry?;
+
+        if entry.file_type()?.is_dir() {
+            bytes += file_bytes(&entry.path(), extension)?;
+        } else if entry
+            .path()
+            .extension()
+            .map_or(false, |ext| ext == extension)
+        {
+            bytes += entry.metadata()?.len();
+        }
+    }
+
+    Ok(bytes)
+}
+
+/// Compiles every top-level file of `unit` in `dir` in its own translation unit.
+///
+/// Real dumps define the same class namespaces in several modules, so the headers can't all be
+/// included from a single unit.
+fn benchmark_mode(compiler: &str, dir: &Path, unit: Unit) -> Result<Value> {
+    let mut headers: Vec<PathBuf> = fs::read_dir(dir)?
+        .map(|entry| entry.map(|entry| entry.path()))
+        .collect::<io::Result<_>>()?;
+
+    headers.retain(|path| {
+        path.extension()
+            .map_or(false, |ext| ext == unit.extension())
+    });
+    headers.sort();
+
+    let mut units = Vec::with_capacity(headers.len());
+
+    let mut total_duration = Duration::ZERO;
+    let mut peak_memory: Option<u64> = None;
+
+    for header in &headers {
+        let source = match unit {
+            Unit::Header => {
+                let source = header.with_extension("cpp");
+
+                fs::write(
+                    &source,
+                    format!(
+                        "#include \"{}\"\n",
+                        header.file_name().unwrap().to_string_lossy()
+                    ),
+                )?;
+
+                source
+            }
+            Unit::ModuleInterface | Unit::Program => header.clone(),
+        };
+
+        let measurement = compile(compiler, &source, unit)?;
+
+        total_duration += measurement.duration;
+        peak_memory = peak_memory.max(measurement.peak_memory);
+
+        units.push(json!({
+            "header": header.file_name().unwrap().to_string_lossy(),
+            "compile_seconds": measurement.duration.as_secs_f64(),
+            "peak_memory_bytes": measurement.peak_memory,
+        }));
+    }
+
+    Ok(json!({
+        "header_bytes": file_bytes(dir, unit.extension())?,
+        "compile_seconds": total_duration.as_secs_f64(),
+        "peak_memory_bytes": peak_memory,
+        "units": units,
+    }))
+}
+
+#[test]
+#[ignore]
+fn compile_generated_headers() -> Result<()> {
+    let database = match env::var_os("CS2_SCHEMA_CACHE") {
+        Some(path) => SchemaDatabase::load(Path::new(&path))?,
+        None => SchemaDatabase::collect(&Session::new(Process::with_source(
+            MockSchemaSystem::generate(4, 2000).build(),
+        ))?)?,
+    };
+
+    let compiler = compiler();
+
+    let root = TempDir(env::temp_dir().join(format!("cs2-dumper-compile-{}", std::process::id())));
+
+    let mut modes = serde_json::Map::new();
+
+    for (name, options) in MODES {
+        let dir = root.0.join(name);
+
+        fs::create_dir_all(&dir)?;
+
+        let (mut builders, unit) = match options {
+            Some(options) => (
+                vec![FileBuilderEnum::CppFileBuilder(CppFileBuilder::new(
+                    *options,
+                ))],
+                Unit::Header,
+            ),
+            None => (
+                vec![FileBuilderEnum::CppModuleFileBuilder(CppModuleFileBuilder)],
+                Unit::ModuleInterface,
+            ),
+        };
+
+        dump_schemas(&mut builders, &database, None, &dir)?;
+
+        let result = benchmark_mode(&compiler, &dir, unit)?;
+
+        println!(
+            "{:<16} {:>10} bytes {:>8.2}s {:>10} peak",
+            name,
+            result["header_bytes"],
+            result["compile_seconds"].as_f64().unwrap_or_default(),
+            result["peak_memory_bytes"]
+        );
+
+        modes.insert(name.to_string(), result);
+    }
+
+    let report_path = env::var_os("CS2_COMPILE_REPORT")
+        .map(PathBuf::from)
+        .unwrap_or_else(|| {
+            let target_dir = env::var_os("CARGO_TARGET_DIR").unwrap_or_else(|| "target".into());
+
+            Path::new(env!("CARGO_MANIFEST_DIR"))
+                .join(target_dir)
+                .join("compile_benchmark.json")
+        });
+
+    if let Some(parent) = report_path.parent() {
+        fs::create_dir_all(parent)?;
+    }
+
+    let report = json!({
+        "compiler": compiler,
+        "classes": database.class_count(),
+        "modes": modes,
+    });
+
+    fs::write(&report_path, serde_json::to_string_pretty(&report)?)?;
+
+    println!("Wrote {}", report_path.display());
+
+    Ok(())
+}
+
+/// Builds a program against the `cs2d.hpp` shipped with every dump and checks that it finds the
+/// value of every entry in the `.cs2d` files, and rejects a key that isn't there.
+///
+/// The values are taken from the JSON files rendered alongside, so the reader is checked against
+/// a second output rather than against the Rust writer it mirrors.
+#[test]
+#[ignore]
+fn compile_cs2d_reader() -> Result<()> {
+    let database = SchemaDatabase::collect(&Session::new(Process::with_source(
+        MockSchemaSystem::generate(2, 200).build(),
+    ))?)?;
+
+    let temp_dir = TempDir(env::temp_dir().join(format!("cs2-dumper-cs2d-{}", std::process::id())));
+    let dir = &temp_dir.0;
+
+    fs::create_dir_all(&dir)?;
+    fs::write(dir.join("cs2d.hpp"), CS2D_READER)?;
+
+    let mut builders = vec![
+        FileBuilderEnum::Cs2dFileBuilder(Cs2dFileBuilder::default()),
+        FileBuilderEnum::JsonFileBuilder(JsonFileBuilder::default()),
+    ];
+
+    dump_schemas(&mut builders, &database, None, &dir)?;
+
+    let mut files: Vec<String> = Vec::new();
+    let mut expected = String::new();
+
+    for module in 0..database.module_count() {
+        let file_name = database.module_name(module);
+
+        let json: Value = serde_json::from_str(&fs::read_to_string(
+            dir.join(format!("{}.json", file_name)),
+        )?)?;
+
+        for (namespace, fields) in json.as_object().unwrap() {
+            for (name, value) in fields.as_object().unwrap() {
+                expected += &format!(
+                    "    {{{}, \"{}::{}::{}\", {:#X}ull}},\n",
+                    files.len(),
+                    file_name,
+                    namespace,
+                    name,
+                    value.as_u64().unwrap()
+                );
+            }
+        }
+
+        files.push(format!("    \"{}.cs2d\",\n", file_name));
+    }
+
+    let source = dir.join("cs2d_reader.cpp");
+
+    fs::write(
+        &source,
+        format!(
+            r#"#include "cs2d.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+struct Expected {{
+    std::size_t file;
+    const char* key;
+    std::uint64_t value;
+}};
+
+static const char* const files[] = {{
+{}}};
+
+static const Expected expected[] = {{
+{}}};
+
+int main() {{
+    std::vector<std::vector<char>> data;
+    std::vector<cs2d::Reader> readers;
+
+    for (const char* file : files) {{
+        std::ifstream stream(file, std::ios::binary);
+
+        data.emplace_back(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+        readers.emplace_back(data.back().data(), data.back().size());
+
+        if (!readers.back().valid() || readers.back().find("missing::C_Missing::m_missing"))
+            return 1;
+    }}
+
+    for (const Expected& entry : expected) {{
+        const cs2d::Entry* found = readers[entry.file].find(entry.key);
+
+        if (!found || found->value != entry.value) {{
+            std::fprintf(stderr, "%s\n", entry.key);
+
+            return 2;
+        }}
+    }}
+
+    std::printf("%zu\n", sizeof(expected) / sizeof(Expected));
+}}
+"#,
+            files.concat(),
+            expected
+        ),
+    )?;
+
+    compile(&compiler(), &source, Unit::Program)?;
+
+    let output = Command::new(source.with_extension(env::consts::EXE_EXTENSION))
+        .current_dir(&dir)
+        .output()?;
+
+    assert!(
+        output.status.success(),
+        "{}",
+        String::from_utf8_lossy(&output.stderr)
+    );
+
+    println!(
+        "Looked up {} keys through cs2d.hpp",
+        String::from_utf8_lossy(&output.stdout).trim()
+    );
+
+    Ok(())
+}
@@ -1,60 +1,72 @@
+use std::path::Path;
+
 use crate::builder::FileBuilderEnum;
 use crate::dumpers::Entry;
 use crate::error::Result;
-use crate::remote::Process;
-
-use super::{generate_files, Entries};
+use crate::session::Session;
 
-pub fn dump_interfaces(builders: &mut Vec<FileBuilderEnum>, process: &Process) -> Result<()> {
-    let module_names = process.get_loaded_modules()?;
+use super::{generate_files, parallel_map, Entries};
 
-    let mut entries = Entries::new();
+pub fn dump_interfaces(
+    builders: &mut Vec<FileBuilderEnum>,
+    session: &Session,
+    output_dir: &Path,
+) -> Result<()> {
+    let module_names: Vec<&str> = session.module_names().collect();
 
-    for module_name in module_names {
-        let module = process.get_module_by_name(&module_name)?;
+    // Each registry is a chain of dependent reads, so the modules are walked concurrently on a
+    // bounded pool of workers.
+    let registries = parallel_map(&module_names, |&module_name| -> Result<_> {
+        let Some(registry) = session.interface_registry(module_name)? else {
+            return Ok(None);
+        };
 
-        if let Some(create_interface_export) = module.export("CreateInterface") {
-            log::info!("Dumping interfaces in {}...", module_name);
+        Ok(Some((
+            module_name,
+            session.module(module_name)?.base(),
+            registry,
+        )))
+    })
+    .into_iter()
+    .filter_map(Result::transpose)
+    .collect::<Result<Vec<_>>>()?;
 
-            let create_interface_address =
-                process.resolve_rip(create_interface_export.va, None, None)?;
+    // The version strings of every module are fetched in one batch.
+    let name_addresses: Vec<usize> = registries
+        .iter()
+        .flat_map(|(_, _, registry)| registry.regs().iter().map(|reg| reg.name))
+        .collect();
 
-            let mut interface_registry_ptr = process
-                .read_memory::<usize>(create_interface_address)
-                .unwrap_or(0);
+    let mut names = session.process().read_strings(&name_addresses).into_iter();
 
-            while interface_registry_ptr != 0 {
-                let interface_ptr = process.read_memory::<usize>(interface_registry_ptr)?;
-
-                let interface_version_ptr =
-                    process.read_memory::<usize>(interface_registry_ptr + 0x8)?;
+    let mut entries = Entries::new();
 
-                let interface_version = process.read_string(interface_version_ptr)?;
+    for (module_name, module_base, registry) in registries {
+        log::info!("Dumping interfaces in {}...", module_name);
 
-                log::debug!(
-                    "  └─ {} @ {:#X} ({} + {:#X})",
-                    interface_version,
-                    interface_ptr,
-                    module_name,
-                    interface_ptr - module.base()
-                );
+        for reg in registry.regs() {
+            let interface_version = names.next().unwrap()?;
 
-                entries
-                    .entry(module_name.replace(".", "_"))
-                    .or_default()
-                    .push(Entry {
-                        name: interface_version.clone(),
-                        value: interface_ptr - module.base(),
-                        comment: None,
-                    });
+            log::debug!(
+                "  └─ {} @ {:#X} ({} + {:#X})",
+                interface_version,
+                reg.create_fn,
+                module_name,
+                reg.create_fn - module_base
+            );
 
-                interface_registry_ptr =
-                    process.read_memory::<usize>(interface_registry_ptr + 0x10)?;
-            }
+            entries
+                .entry(module_name.replace(".", "_"))
+                .or_default()
+                .push(Entry {
+                    name: interface_version,
+                    value: reg.create_fn - module_base,
+                    comment: None,
+                });
         }
     }
 
-    generate_files(builders, &entries, "interfaces")?;
+    generate_files(builders, &entries, output_dir, "interfaces")?;
 
     Ok(())
 }
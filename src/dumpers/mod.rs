@@ -1,17 +1,28 @@
 use std::collections::BTreeMap;
 use std::fs::File;
-use std::io::Write;
-
-use crate::builder::{FileBuilder, FileBuilderEnum};
+use std::io::{self, Write};
+use std::path::Path;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::Mutex;
+use std::thread;
+use std::time::Instant;
+
+use crate::alloc_stats::{self, Phase};
+use crate::builder::{ClassLayouts, FileBuilder, FileBuilderEnum};
 use crate::error::Result;
 
 pub use interfaces::dump_interfaces;
 pub use offsets::dump_offsets;
-pub use schemas::dump_schemas;
+pub use schemas::{collect_and_dump_schemas, dump_schemas};
+pub use signature_health::check_signature_health;
 
+#[cfg(test)]
+mod compile_benchmark;
 pub mod interfaces;
 pub mod offsets;
 pub mod schemas;
+pub mod signature_graph;
+pub mod signature_health;
 
 pub struct Entry {
     pub name: String,
@@ -21,22 +32,27 @@ pub struct Entry {
 
 pub type Entries = BTreeMap<String, Vec<Entry>>;
 
+/// A named unit of work run by `run_tasks`.
+pub type Task<'a> = (&'static str, Box<dyn FnOnce() -> Result<()> + Send + 'a>);
+
 pub fn generate_file(
     builder: &mut FileBuilderEnum,
     entries: &Entries,
+    layouts: &ClassLayouts,
+    output_dir: &Path,
     file_name: &str,
-) -> Result<()> {
+) -> io::Result<()> {
     if entries.is_empty() {
         return Ok(());
     }
 
-    let file_path = format!("generated/{}.{}", file_name, builder.extension());
+    let file_path = output_dir.join(file_name);
 
-    let mut file = File::create(file_path)?;
+    let mut file = File::create(output_dir.join(format!("{}.{}", file_name, builder.extension())))?;
 
-    builder.write_top_level(&mut file)?;
+    builder.write_top_level(&mut file, &file_path)?;
 
-    if builder.extension() != "json" {
+    if !matches!(builder.extension(), "json" | "cs2d") {
         write!(
             file,
             "// Created using https://github.com/a2x/cs2-dumper\n// {}\n\n",
@@ -58,6 +74,10 @@ pub fn generate_file(
             )?;
         }
 
+        if let Some(layout) = layouts.get(pair.0) {
+            builder.write_layout(&mut file, layout)?;
+        }
+
         builder.write_closure(&mut file, i == len - 1)?;
     }
 
@@ -67,11 +87,120 @@ pub fn generate_file(
 pub fn generate_files(
     builders: &mut Vec<FileBuilderEnum>,
     entries: &Entries,
+    output_dir: &Path,
     file_name: &str,
 ) -> Result<()> {
-    for builder in builders {
-        generate_file(builder, &entries, file_name)?;
-    }
+    render_in_parallel(builders, |builder| {
+        generate_file(
+            builder,
+            entries,
+            &ClassLayouts::new(),
+            output_dir,
+            file_name,
+        )
+    })
+}
+
+/// Runs `render` for every builder on its own thread.
+pub fn render_in_parallel<F>(builders: &mut Vec<FileBuilderEnum>, render: F) -> Result<()>
+where
+    F: Fn(&mut FileBuilderEnum) -> io::Result<()> + Sync,
+{
+    let render = &render;
+
+    let _emission = alloc_stats::enter(Phase::FileEmission);
+
+    thread::scope(|scope| {
+        let handles: Vec<_> = builders
+            .iter_mut()
+            .map(|builder| scope.spawn(alloc_stats::inherit(move || render(builder))))
+            .collect();
+
+        handles
+            .into_iter()
+            .try_for_each(|handle| handle.join().unwrap())
+    })?;
 
     Ok(())
 }
+
+/// Runs `f` for every item on a pool of worker threads and returns the results in order.
+pub fn parallel_map<T, R, F>(items: &[T], f: F) -> Vec<R>
+where
+    T: Sync,
+    R: Send,
+    F: Fn(&T) -> R + Sync,
+{
+    let next_item = AtomicUsize::new(0);
+
+    let results: Mutex<Vec<Option<R>>> = Mutex::new(items.iter().map(|_| None).collect());
+
+    let worker_count = thread::available_parallelism()
+        .map_or(1, |count| count.get())
+        .min(items.len());
+
+    thread::scope(|scope| {
+        for _ in 0..worker_count {
+            scope.spawn(alloc_stats::inherit(|| loop {
+                let index = next_item.fetch_add(1, Ordering::Relaxed);
+
+                let Some(item) = items.get(index) else {
+                    break;
+                };
+
+                let result = f(item);
+
+                results.lock().unwrap()[index] = Some(result);
+            }));
+        }
+    });
+
+    results
+        .into_inner()
+        .unwrap()
+        .into_iter()
+        .map(Option::unwrap)
+        .collect()
+}
+
+/// Runs every task on its own thread and returns the first error once all of them have finished.
+///
+/// Tasks that need the same module data wait on each other through the session's caches, so the
+/// total time approaches that of the slowest task.
+pub fn run_tasks(tasks: Vec<Task<'_>>) -> Result<()> {
+    let results: Vec<(&str, Result<()>)> = thread::scope(|scope| {
+        let handles: Vec<_> = tasks
+            .into_iter()
+            .map(|(name, run)| {
+                let handle = scope.spawn(alloc_stats::inherit(move || {
+                    let start_time = Instant::now();
+
+                    let result = run();
+
+                    log::debug!("Finished {} in {:?}.", name, start_time.elapsed());
+
+                    result
+                }));
+
+                (name, handle)
+            })
+            .collect();
+
+        handles
+            .into_iter()
+            .map(|(name, handle)| (name, handle.join().unwrap()))
+            .collect()
+    });
+
+    let mut first_error = None;
+
+    for (name, result) in results {
+        if let Err(e) = result {
+            log::error!("Failed to dump {}: {}", name, e);
+
+            first_error.get_or_insert(e);
+        }
+    }
+
+    first_error.map_or(Ok(()), Err)
+}
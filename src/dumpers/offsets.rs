@@ -1,18 +1,82 @@
 use std::fs::File;
+use std::path::Path;
 
 use crate::builder::FileBuilderEnum;
-use crate::config::{Config, Operation::*};
+use crate::config::{Config, Operation, Operation::*};
 use crate::dumpers::Entry;
 use crate::error::{Error, Result};
 use crate::mem::Address;
-use crate::remote::Process;
+use crate::session::Session;
 
+use super::signature_graph::SignatureGraph;
 use super::{generate_files, Entries};
 
 #[cfg(test)]
 mod tests {
+    use std::sync::atomic::Ordering;
+
     use super::*;
 
+    use crate::mem::Pattern;
+    use crate::remote::{BufferMemorySource, Process};
+
+    #[test]
+    fn near_scan() -> Result<()> {
+        let mut data = vec![0; 0x1000];
+
+        data[0x100..0x103].copy_from_slice(&[0x48, 0x8B, 0x0D]);
+        data[0x400..0x403].copy_from_slice(&[0x48, 0x8B, 0x0D]);
+        data[0x480..0x483].copy_from_slice(&[0x48, 0x8B, 0x0D]);
+
+        let mut source = BufferMemorySource::new();
+
+        source.add_module("client.dll", 0x10000, data);
+
+        let session = Session::new(Process::with_source(source))?;
+
+        let near_scan = |range, backward| NearScan {
+            pattern: Pattern::new("48 8B 0D").unwrap(),
+            range,
+            backward: Some(backward),
+        };
+
+        // The nearest match in either direction, and none if it starts outside the range.
+        assert_eq!(
+            resolve_operations(&session, 0x10200, &[near_scan(0x300, false)])?,
+            0x10400
+        );
+        assert_eq!(
+            resolve_operations(&session, 0x10500, &[near_scan(0x300, true)])?,
+            0x10480
+        );
+        assert!(matches!(
+            resolve_operations(&session, 0x10200, &[near_scan(0x200, false)]),
+            Err(Error::PatternNotFound)
+        ));
+
+        // A range from the config that runs past the end of the address space is clipped.
+        assert_eq!(
+            resolve_operations(&session, 0x10200, &[near_scan(usize::MAX, false)])?,
+            0x10400
+        );
+
+        // Patterns are parsed along with the config.
+        let operation: Operation =
+            serde_json::from_str(r#"{"type": "nearScan", "pattern": "48 8B ? 0D", "range": 16}"#)?;
+
+        assert!(matches!(operation, NearScan { ref pattern, .. } if pattern.len() == 4));
+        assert!(serde_json::from_str::<Operation>(
+            r#"{"type": "nearScan", "pattern": "48 XX", "range": 16}"#
+        )
+        .is_err());
+
+        // Only the image of the module is searched, the process is not read again.
+        assert_eq!(session.stats().image_reads.load(Ordering::Relaxed), 1);
+
+        Ok(())
+    }
+
+    #[cfg(windows)]
     #[test]
     fn build_number() -> Result<()> {
         let process = Process::new("cs2.exe")?;
@@ -26,6 +90,7 @@ mod tests {
         Ok(())
     }
 
+    #[cfg(windows)]
     #[test]
     fn global_vars() -> Result<()> {
         let process = Process::new("cs2.exe")?;
@@ -42,6 +107,7 @@ mod tests {
         Ok(())
     }
 
+    #[cfg(windows)]
     #[test]
     fn local_player() -> Result<()> {
         let process = Process::new("cs2.exe")?;
@@ -57,6 +123,7 @@ mod tests {
         Ok(())
     }
 
+    #[cfg(windows)]
     #[test]
     fn window_size() -> Result<()> {
         let process = Process::new("cs2.exe")?;
@@ -72,7 +139,11 @@ mod tests {
     }
 }
 
-pub fn dump_offsets(builders: &mut Vec<FileBuilderEnum>, process: &Process) -> Result<()> {
+pub fn dump_offsets(
+    builders: &mut Vec<FileBuilderEnum>,
+    session: &Session,
+    output_dir: &Path,
+) -> Result<()> {
     let file = File::open("config.json")?;
 
     let config: Config = serde_json::from_reader(file).map_err(Error::SerdeError)?;
@@ -81,78 +152,133 @@ pub fn dump_offsets(builders: &mut Vec<FileBuilderEnum>, process: &Process) -> R
 
     log::info!("Dumping offsets...");
 
-    for signature in config.signatures {
-        let module = process.get_module_by_name(&signature.module)?;
-
-        if let Ok(address) = process.find_pattern(&signature.module, &signature.pattern) {
-            let mut address = Address::from(address);
-
-            for operation in signature.operations {
-                match operation {
-                    Add { value } => address += value,
-                    Dereference { times, size } => {
-                        let times = times.unwrap_or(1);
-                        let size = size.unwrap_or(8);
-
-                        for _ in 0..times {
-                            process.read_memory_raw(
-                                address.0,
-                                &mut address.0 as *mut _ as *mut _,
-                                size,
-                            )?;
-                        }
-                    }
-                    Jmp { offset, length } => {
-                        address = process.resolve_jmp(address.0, offset, length)?.into()
-                    }
-                    RipRelative { offset, length } => {
-                        address = process.resolve_rip(address.0, offset, length)?.into()
-                    }
-                    Slice { start, end } => {
-                        let mut result: usize = 0;
+    let graph = SignatureGraph::new(&config.signatures)?;
 
-                        process.read_memory_raw(
-                            address.add(start).0,
-                            &mut result as *mut _ as *mut _,
-                            end - start,
-                        )?;
+    for (signature, resolution) in config.signatures.iter().zip(graph.resolve(session, 1)) {
+        let module = session.module(&signature.module)?;
 
-                        address = result.into();
-                    }
-                    Subtract { value } => address -= value,
-                }
+        let address = match resolution.value {
+            Ok(address) => Address::from(address),
+            Err(Error::PatternNotFound) => {
+                log::error!("Failed to find pattern for {}.", signature.name);
+
+                continue;
+            }
+            Err(e) => {
+                log::error!("Failed to resolve {}: {}", signature.name, e);
+
+                continue;
             }
+        };
 
-            let (name, value) = if address.0 < module.base() {
-                log::debug!("  └─ {} @ {:#X}", signature.name, address.0);
-
-                (signature.name, address.0)
-            } else {
-                log::debug!(
-                    "  └─ {} @ {:#X} ({} + {:#X})",
-                    signature.name,
-                    address,
-                    signature.module,
-                    address.sub(module.base())
-                );
-
-                (signature.name, address.sub(module.base()).0)
-            };
-
-            entries
-                .entry(signature.module.replace(".", "_"))
-                .or_default()
-                .push(Entry {
-                    name,
-                    value,
-                    comment: None,
-                });
+        let (name, value) = if address.0 < module.base() {
+            log::debug!("  └─ {} @ {:#X}", signature.name, address.0);
+
+            (signature.name.clone(), address.0)
         } else {
-            log::error!("Failed to find pattern for {}.", signature.name);
-        }
+            log::debug!(
+                "  └─ {} @ {:#X} ({} + {:#X})",
+                signature.name,
+                address,
+                signature.module,
+                address.sub(module.base())
+            );
+
+            (signature.name.clone(), address.sub(module.base()).0)
+        };
+
+        entries
+            .entry(signature.module.replace(".", "_"))
+            .or_default()
+            .push(Entry {
+                name,
+                value,
+                comment: None,
+            });
     }
 
-    generate_files(builders, &entries, "offsets")?;
+    generate_files(builders, &entries, output_dir, "offsets")?;
 
     Ok(())
 }
+
+pub fn resolve_operations(
+    session: &Session,
+    address: usize,
+    operations: &[Operation],
+) -> Result<usize> {
+    let mut address = Address::from(address);
+
+    for operation in operations {
+        match *operation {
+            Add { value } => address += value,
+            Dereference { times, size } => {
+                let times = times.unwrap_or(1);
+                let size = size.unwrap_or(8);
+
+                for _ in 0..times {
+                    let pointer = address.0;
+
+                    // Narrower reads only replace the low bytes of the address.
+                    let mut buffer = address.0.to_le_bytes();
+
+                    session.read_memory_raw(address.0, &mut buffer[..size.min(8)])?;
+
+                    address.0 = usize::from_le_bytes(buffer);
+
+                    // Globals that are only assigned at runtime read as null when resolving
+                    // against images on disk.
+                    if address.0 == 0 {
+                        return Err(Error::NullPointer(pointer));
+                    }
+                }
+            }
+            Jmp { offset, length } => {
+                address = session.resolve_jmp(address.0, offset, length)?.into()
+            }
+            NearScan {
+                ref pattern,
+                range,
+                backward,
+            } => {
+                // The match has to start within `range` bytes, but may extend past them.
+                let tail = pattern.len() - 1;
+
+                let found = if backward.unwrap_or(false) {
+                    session
+                        .find_pattern_in(
+                            pattern,
+                            address.0.saturating_sub(range),
+                            address.0.saturating_add(tail),
+                            usize::MAX,
+                        )?
+                        .last()
+                        .copied()
+                } else {
+                    let end = address.0.saturating_add(range).saturating_add(tail);
+
+                    session
+                        .find_pattern_in(pattern, address.0, end, 1)?
+                        .first()
+                        .copied()
+                };
+
+                address = found.ok_or(Error::PatternNotFound)?.into();
+            }
+            RipRelative { offset, length } => {
+                address = session.resolve_rip(address.0, offset, length)?.into()
+            }
+            Slice { start, end } => {
+                let mut buffer = [0; 8];
+
+                session
+                    .read_memory_raw(address.add(start).0, &mut buffer[..(end - start).min(8)])?;
+
+                address = usize::from_le_bytes(buffer).into();
+            }
+            Subtract { value } => address -= value,
+        }
+    }
+
+    Ok(address.0)
+}
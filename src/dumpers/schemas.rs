@@ -1,49 +1,183 @@
-use crate::builder::FileBuilderEnum;
-use crate::dumpers::Entry;
+use std::path::Path;
+use std::slice;
+use std::sync::mpsc;
+use std::thread;
+
+use crate::alloc_stats;
+use crate::builder::{ClassLayouts, FileBuilderEnum};
 use crate::error::Result;
-use crate::remote::Process;
-use crate::sdk::SchemaSystem;
+use crate::schema::SchemaDatabase;
+use crate::session::Session;
+
+use super::{generate_file, render_in_parallel, Entries};
+
+/// The files of one module, ready to be rendered.
+struct ModuleFiles {
+    name: String,
+    entries: Entries,
+    layouts: ClassLayouts,
+}
 
-use super::{generate_files, Entries};
+impl ModuleFiles {
+    fn new(database: &SchemaDatabase, module: usize, read_span_gap: Option<usize>) -> Self {
+        let mut layouts = database.layouts(module);
 
-pub fn dump_schemas(builders: &mut Vec<FileBuilderEnum>, process: &Process) -> Result<()> {
-    let schema_system = SchemaSystem::new(&process)?;
+        if let Some(max_gap) = read_span_gap {
+            for layout in layouts.values_mut() {
+                layout.read_spans = layout.read_spans(max_gap);
+            }
+        }
 
-    for type_scope in schema_system.type_scopes()? {
-        let module_name = type_scope.module_name()?;
+        Self {
+            name: database.module_name(module).to_string(),
+            entries: database.entries(module),
+            layouts,
+        }
+    }
+}
 
-        log::info!("Generating files for {}...", module_name);
+/// Renders every module in `database`. If `read_span_gap` is set, each class layout also carries
+/// its fields merged into read spans that skip at most that many bytes.
+pub fn dump_schemas(
+    builders: &mut Vec<FileBuilderEnum>,
+    database: &SchemaDatabase,
+    read_span_gap: Option<usize>,
+    output_dir: &Path,
+) -> Result<()> {
+    let modules: Vec<ModuleFiles> = (0..database.module_count())
+        .map(|module| {
+            log::info!("Generating files for {}...", database.module_name(module));
 
-        let mut entries = Entries::new();
+            ModuleFiles::new(database, module, read_span_gap)
+        })
+        .collect();
 
-        for class in type_scope.classes()? {
-            log::debug!("  {}", class.name());
+    render_modules(builders, &modules, output_dir)
+}
 
-            for field in class.fields()? {
-                let field_name = field.name()?;
-                let field_offset = field.offset()?;
-                let field_type_name = field.r#type()?.name()?;
+/// Reads the schemas through `session` and renders each module while the next one is read.
+///
+/// Classes can refer to classes of modules that haven't been read yet, so once everything is
+/// read the layouts are worked out again and only modules whose layouts changed are rendered a
+/// second time. The output is the same as collecting first and calling `dump_schemas`.
+pub fn collect_and_dump_schemas(
+    builders: &mut Vec<FileBuilderEnum>,
+    session: &Session,
+    read_span_gap: Option<usize>,
+    output_dir: &Path,
+) -> Result<SchemaDatabase> {
+    let (sender, receiver) = mpsc::channel::<ModuleFiles>();
 
-                log::debug!(
-                    "    └─ {} = {:#X} // {}",
-                    field_name,
-                    field_offset,
-                    field_type_name
-                );
+    let emitter_builders = &mut *builders;
 
-                entries
-                    .entry(class.name().replace("::", "_"))
-                    .or_default()
-                    .push(Entry {
-                        name: field_name,
-                        value: field_offset as usize,
-                        comment: Some(field_type_name),
-                    });
-            }
-        }
+    let (database, rendered) = thread::scope(|scope| {
+        let emitter = scope.spawn(alloc_stats::inherit(
+            move || -> Result<Vec<ClassLayouts>> {
+                let mut rendered = Vec::new();
 
-        generate_files(builders, &entries, &module_name)?;
+                for module in receiver {
+                    log::info!("Generating files for {}...", module.name);
+
+                    render_modules(emitter_builders, slice::from_ref(&module), output_dir)?;
+
+                    rendered.push(module.layouts);
+                }
+
+                Ok(rendered)
+            },
+        ));
+
+        // If rendering fails the receiver is gone, the remaining modules are still read and the
+        // error is returned afterwards.
+        let database = SchemaDatabase::collect_with(session, move |database, module| {
+            let _ = sender.send(ModuleFiles::new(database, module, read_span_gap));
+        });
+
+        let rendered = emitter.join().unwrap();
+
+        database.and_then(|database| Ok((database, rendered?)))
+    })?;
+
+    let stale: Vec<ModuleFiles> = (0..database.module_count())
+        .map(|module| ModuleFiles::new(&database, module, read_span_gap))
+        .zip(&rendered)
+        .filter(|(module, layouts)| module.layouts != **layouts)
+        .map(|(module, _)| module)
+        .collect();
+
+    for module in &stale {
+        log::debug!("Rewriting {} with the final class layouts.", module.name);
     }
 
-    Ok(())
+    render_modules(builders, &stale, output_dir)?;
+
+    Ok(database)
+}
+
+fn render_modules(
+    builders: &mut Vec<FileBuilderEnum>,
+    modules: &[ModuleFiles],
+    output_dir: &Path,
+) -> Result<()> {
+    if modules.is_empty() {
+        return Ok(());
+    }
+
+    render_in_parallel(builders, |builder| {
+        for module in modules {
+            generate_file(
+                builder,
+                &module.entries,
+                &module.layouts,
+                output_dir,
+                &module.name,
+            )?;
+        }
+
+        Ok(())
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use std::{env, fs};
+
+    use super::*;
+
+    use crate::builder::JsonFileBuilder;
+    use crate::remote::Process;
+    use crate::sdk::mock_schema_system::MockSchemaSystem;
+
+    #[test]
+    fn streamed_output_matches() -> Result<()> {
+        let mock = MockSchemaSystem::generate(3, 100);
+
+        let session = Session::new(Process::with_source(mock.build()))?;
+
+        let root = env::temp_dir().join(format!("cs2-dumper-schemas-{}", std::process::id()));
+
+        let (streamed, collected) = (root.join("streamed"), root.join("collected"));
+
+        fs::create_dir_all(&streamed)?;
+        fs::create_dir_all(&collected)?;
+
+        let new_builders = || vec![FileBuilderEnum::JsonFileBuilder(JsonFileBuilder::default())];
+
+        let database = collect_and_dump_schemas(&mut new_builders(), &session, Some(8), &streamed)?;
+
+        dump_schemas(&mut new_builders(), &database, Some(8), &collected)?;
+
+        for scope in &mock.type_scopes {
+            let file_name = format!("{}.json", scope.module_name);
+
+            assert_eq!(
+                fs::read(streamed.join(&file_name))?,
+                fs::read(collected.join(&file_name))?
+            );
+        }
+
+        fs::remove_dir_all(&root)?;
+
+        Ok(())
+    }
 }
@@ -0,0 +1,302 @@
+use std::collections::{BTreeMap, HashMap};
+
+use crate::config::Signature;
+use crate::error::{Error, Result};
+use crate::mem::Pattern;
+use crate::session::Session;
+
+use super::offsets::resolve_operations;
+use super::parallel_map;
+
+/// Number of bytes after the base searched for the pattern of a signature without a `window`.
+const DEFAULT_WINDOW: usize = 0x1000;
+
+/// The result of resolving one signature.
+pub struct Resolution {
+    /// Matches of the pattern, or the base address for signatures without one.
+    pub matches: Vec<usize>,
+    pub value: Result<usize>,
+}
+
+impl Resolution {
+    fn failed(error: Error) -> Self {
+        Self {
+            matches: Vec::new(),
+            value: Err(error),
+        }
+    }
+}
+
+/// The signatures of `config.json`, ordered so that every signature is resolved after the one it
+/// starts from.
+///
+/// Signatures without a base are scanned for in their whole module, each module once for all of
+/// them. The rest only search a small window after their base, or start right at it.
+pub struct SignatureGraph<'a> {
+    signatures: &'a [Signature],
+    patterns: Vec<Option<Pattern>>,
+    bases: Vec<Option<usize>>,
+    levels: Vec<Vec<usize>>,
+}
+
+impl<'a> SignatureGraph<'a> {
+    pub fn new(signatures: &'a [Signature]) -> Result<Self> {
+        let indices: HashMap<&str, usize> = signatures
+            .iter()
+            .enumerate()
+            .map(|(i, signature)| (signature.name.as_str(), i))
+            .collect();
+
+        let bases = signatures
+            .iter()
+            .map(|signature| {
+                signature
+                    .base
+                    .as_deref()
+                    .map(|base| {
+                        indices
+                            .get(base)
+                            .copied()
+                            .ok_or_else(|| Error::SignatureNotFound(base.to_string()))
+                    })
+                    .transpose()
+            })
+            .collect::<Result<Vec<_>>>()?;
+
+        let patterns = signatures
+            .iter()
+            .map(|signature| match (&signature.pattern, &signature.base) {
+                (Some(pattern), _) => Pattern::new(pattern).map(Some),
+                (None, Some(_)) => Ok(None),
+                (None, None) => Err(Error::InvalidPattern(format!(
+                    "{} has neither a pattern nor a base",
+                    signature.name
+                ))),
+            })
+            .collect::<Result<Vec<_>>>()?;
+
+        // Every signature has at most one base, so its level is one more than that of its base.
+        let mut depths: Vec<Option<usize>> = bases
+            .iter()
+            .map(|base| base.is_none().then_some(0))
+            .collect();
+
+        loop {
+            let mut progress = false;
+
+            for i in 0..signatures.len() {
+                if depths[i].is_none() {
+                    if let Some(depth) = bases[i].and_then(|base| depths[base]) {
+                        depths[i] = Some(depth + 1);
+
+                        progress = true;
+                    }
+                }
+            }
+
+            if !progress {
+                break;
+            }
+        }
+
+        let mut levels: Vec<Vec<usize>> = Vec::new();
+
+        for (i, depth) in depths.into_iter().enumerate() {
+            // Whatever is left can only be reached through a cycle.
+            let depth = depth.ok_or_else(|| Error::CyclicSignature(signatures[i].name.clone()))?;
+
+            if levels.len() <= depth {
+                levels.resize(depth + 1, Vec::new());
+            }
+
+            levels[depth].push(i);
+        }
+
+        Ok(Self {
+            signatures,
+            patterns,
+            bases,
+            levels,
+        })
+    }
+
+    /// Resolves every signature, level by level, and returns the results in the order of the
+    /// signatures. Up to `max_matches` matches of each pattern are recorded.
+    pub fn resolve(&self, session: &Session, max_matches: usize) -> Vec<Resolution> {
+        let mut resolutions: Vec<Option<Resolution>> =
+            self.signatures.iter().map(|_| None).collect();
+
+        let Some((roots, dependents)) = self.levels.split_first() else {
+            return Vec::new();
+        };
+
+        let mut modules: BTreeMap<&str, Vec<usize>> = BTreeMap::new();
+
+        for &i in roots {
+            modules
+                .entry(self.signatures[i].module.as_str())
+                .or_default()
+                .push(i);
+        }
+
+        let modules: Vec<(&str, Vec<usize>)> = modules.into_iter().collect();
+
+        // Modules are scanned concurrently, each once for all of its signatures.
+        let module_resolutions = parallel_map(&modules, |(module_name, indices)| {
+            self.resolve_module(session, module_name, indices, max_matches)
+        });
+
+        for ((_, indices), module_resolutions) in modules.iter().zip(module_resolutions) {
+            for (&i, resolution) in indices.iter().zip(module_resolutions) {
+                resolutions[i] = Some(resolution);
+            }
+        }
+
+        for level in dependents {
+            let level_resolutions = parallel_map(level, |&i| {
+                let base = self.bases[i].unwrap();
+
+                match &resolutions[base].as_ref().unwrap().value {
+                    Ok(address) => self.resolve_dependent(session, i, *address, max_matches),
+                    Err(_) => Resolution::failed(Error::UnresolvedBase(
+                        self.signatures[base].name.clone(),
+                    )),
+                }
+            });
+
+            for (&i, resolution) in level.iter().zip(level_resolutions) {
+                resolutions[i] = Some(resolution);
+            }
+        }
+
+        resolutions.into_iter().map(Option::unwrap).collect()
+    }
+
+    fn resolve_module(
+        &self,
+        session: &Session,
+        module_name: &str,
+        indices: &[usize],
+        max_matches: usize,
+    ) -> Vec<Resolution> {
+        let patterns: Vec<Pattern> = indices
+            .iter()
+            .map(|&i| self.patterns[i].clone().unwrap())
+            .collect();
+
+        let Ok(matches) = session.find_pattern_matches(module_name, &patterns, max_matches) else {
+            return indices
+                .iter()
+                .map(|_| Resolution::failed(Error::ModuleNotFound))
+                .collect();
+        };
+
+        indices
+            .iter()
+            .zip(matches)
+            .map(|(&i, matches)| self.finish(session, i, matches))
+            .collect()
+    }
+
+    fn resolve_dependent(
+        &self,
+        session: &Session,
+        i: usize,
+        base: usize,
+        max_matches: usize,
+    ) -> Resolution {
+        let matches = match &self.patterns[i] {
+            Some(pattern) => {
+                let window = self.signatures[i].window.unwrap_or(DEFAULT_WINDOW);
+
+                match session.find_pattern_in(
+                    pattern,
+                    base,
+                    base.saturating_add(window),
+                    max_matches,
+                ) {
+                    Ok(matches) => matches,
+                    Err(e) => return Resolution::failed(e),
+                }
+            }
+            None => vec![base],
+        };
+
+        self.finish(session, i, matches)
+    }
+
+    /// Applies the operations of a signature to its first match.
+    fn finish(&self, session: &Session, i: usize, matches: Vec<usize>) -> Resolution {
+        let value = matches
+            .first()
+            .ok_or(Error::PatternNotFound)
+            .and_then(|&address| {
+                resolve_operations(session, address, &self.signatures[i].operations)
+            });
+
+        Resolution { matches, value }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    use crate::remote::{BufferMemorySource, Process};
+
+    fn signature(name: &str, pattern: Option<&str>, base: Option<&str>) -> Signature {
+        Signature {
+            name: name.to_string(),
+            module: "client.dll".to_string(),
+            pattern: pattern.map(str::to_string),
+            base: base.map(str::to_string),
+            window: Some(0x100),
+            operations: Vec::new(),
+        }
+    }
+
+    #[test]
+    fn resolve_in_dependency_order() -> Result<()> {
+        let mut data = vec![0; 0x2000];
+
+        // The dependent pattern also occurs before the anchor, where it must not be found.
+        data[0x100..0x103].copy_from_slice(&[0x48, 0x8B, 0x0D]);
+        data[0x1000..0x1004].copy_from_slice(&[0xE8, 0xCC, 0xCC, 0xE8]);
+        data[0x1040..0x1043].copy_from_slice(&[0x48, 0x8B, 0x0D]);
+
+        let mut source = BufferMemorySource::new();
+
+        source.add_module("client.dll", 0x10000, data);
+
+        let session = Session::new(Process::with_source(source))?;
+
+        // Listed before their bases on purpose.
+        let signatures = vec![
+            signature("derived", Some("48 8B 0D"), Some("anchor")),
+            signature("aliased", None, Some("derived")),
+            signature("anchor", Some("E8 CC CC E8"), None),
+        ];
+
+        let graph = SignatureGraph::new(&signatures)?;
+
+        let values: Vec<usize> = graph
+            .resolve(&session, 1)
+            .into_iter()
+            .map(|resolution| resolution.value)
+            .collect::<Result<_>>()?;
+
+        assert_eq!(values, [0x11040, 0x11040, 0x11000]);
+
+        let cyclic = vec![
+            signature("a", None, Some("b")),
+            signature("b", None, Some("a")),
+        ];
+
+        assert!(matches!(
+            SignatureGraph::new(&cyclic),
+            Err(Error::CyclicSignature(_))
+        ));
+
+        Ok(())
+    }
+}
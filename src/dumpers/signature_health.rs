@@ -0,0 +1,319 @@
+use std::fs::{self, File};
+use std::path::{Path, PathBuf};
+
+use serde::Serialize;
+
+use crate::config::Config;
+use crate::error::{Error, Result};
+use crate::remote::{PeMemorySource, Process};
+use crate::session::Session;
+
+use super::parallel_map;
+use super::signature_graph::SignatureGraph;
+
+/// Matches beyond this many are not counted, a signature is fragile long before that.
+const MAX_MATCHES: usize = 8;
+
+#[derive(Clone, Copy, Debug, PartialEq, Serialize)]
+#[serde(rename_all = "camelCase")]
+pub enum Status {
+    Healthy,
+    Unresolved,
+    Duplicate,
+    NotFound,
+    ModuleMissing,
+}
+
+impl Status {
+    /// Single character used in the logged matrix.
+    fn symbol(self) -> char {
+        match self {
+            Status::Healthy => '.',
+            Status::Unresolved => 'R',
+            Status::Duplicate => 'D',
+            Status::NotFound => '-',
+            Status::ModuleMissing => 'M',
+        }
+    }
+}
+
+#[derive(Debug, Serialize)]
+pub struct SignatureResult {
+    pub status: Status,
+    /// Number of matches in the module, capped at `MAX_MATCHES`.
+    pub matches: usize,
+    /// RVA of the first match.
+    pub rva: Option<usize>,
+    /// Resolved value, relative to the module base if it points into the module.
+    pub value: Option<usize>,
+    pub error: Option<String>,
+}
+
+impl SignatureResult {
+    fn module_missing(error: &Error) -> Self {
+        Self {
+            status: Status::ModuleMissing,
+            matches: 0,
+            rva: None,
+            value: None,
+            error: Some(error.to_string()),
+        }
+    }
+}
+
+#[derive(Debug, Serialize)]
+pub struct SignatureReport {
+    pub name: String,
+    pub module: String,
+    /// One result per build, in the order of `HealthReport::builds`.
+    pub results: Vec<SignatureResult>,
+}
+
+#[derive(Debug, Serialize)]
+pub struct HealthReport {
+    pub builds: Vec<String>,
+    pub signatures: Vec<SignatureReport>,
+}
+
+/// Runs every signature in `config.json` against every build in `archive` and writes a matrix of
+/// the results to `signature_health.json` in `output_dir`.
+///
+/// Each subdirectory of `archive` is one build holding the PE files of its modules. Builds are
+/// checked in parallel, and each module is scanned once for all of its signatures.
+pub fn check_signature_health(archive: &Path, output_dir: &Path) -> Result<()> {
+    let file = File::open("config.json")?;
+
+    let config: Config = serde_json::from_reader(file).map_err(Error::SerdeError)?;
+
+    let graph = SignatureGraph::new(&config.signatures)?;
+
+    let mut builds: Vec<PathBuf> = fs::read_dir(archive)?
+        .filter_map(|entry| entry.ok().map(|entry| entry.path()))
+        .filter(|path| path.is_dir())
+        .collect();
+
+    builds.sort();
+
+    log::info!(
+        "Checking {} signatures against {} builds...",
+        config.signatures.len(),
+        builds.len()
+    );
+
+    let mut results: Vec<_> = parallel_map(&builds, |build| check_build(&config, &graph, build))
+        .into_iter()
+        .map(Vec::into_iter)
+        .collect();
+
+    let report = HealthReport {
+        builds: builds
+            .iter()
+            .map(|build| build.file_name().unwrap().to_string_lossy().into_owned())
+            .collect(),
+        signatures: config
+            .signatures
+            .iter()
+            .map(|signature| SignatureReport {
+                name: signature.name.clone(),
+                module: signature.module.clone(),
+                results: results
+                    .iter_mut()
+                    .map(|results| results.next().unwrap())
+                    .collect(),
+            })
+            .collect(),
+    };
+
+    log_matrix(&report);
+
+    fs::create_dir_all(output_dir)?;
+
+    let path = output_dir.join("signature_health.json");
+
+    fs::write(&path, serde_json::to_string_pretty(&report)?)?;
+
+    log::info!("Wrote {}", path.display());
+
+    Ok(())
+}
+
+/// Returns the result of every signature against a single build.
+fn check_build(config: &Config, graph: &SignatureGraph, build: &Path) -> Vec<SignatureResult> {
+    let session = match PeMemorySource::new(&[build.to_path_buf()])
+        .and_then(|source| Session::new(Process::with_source(source)))
+    {
+        Ok(session) => session,
+        Err(e) => {
+            log::warn!("Skipping {}: {}", build.display(), e);
+
+            return config
+                .signatures
+                .iter()
+                .map(|_| SignatureResult::module_missing(&e))
+                .collect();
+        }
+    };
+
+    check_session(config, graph, &session)
+}
+
+/// Returns the result of every signature against the modules of `session`.
+fn check_session(
+    config: &Config,
+    graph: &SignatureGraph,
+    session: &Session,
+) -> Vec<SignatureResult> {
+    config
+        .signatures
+        .iter()
+        .zip(graph.resolve(session, MAX_MATCHES))
+        .map(|(signature, resolution)| {
+            let base = match session.module_base(&signature.module) {
+                Ok(base) => base,
+                Err(e) => return SignatureResult::module_missing(&e),
+            };
+
+            let (value, error) = match resolution.value {
+                Ok(value) if value >= base => (Some(value - base), None),
+                Ok(value) => (Some(value), None),
+                Err(e) => (None, Some(e.to_string())),
+            };
+
+            let status = match (resolution.matches.len(), value) {
+                (0, _) => Status::NotFound,
+                (1, Some(_)) => Status::Healthy,
+                (1, None) => Status::Unresolved,
+                _ => Status::Duplicate,
+            };
+
+            SignatureResult {
+                status,
+                matches: resolution.matches.len(),
+                rva: resolution
+                    .matches
+                    .first()
+                    .and_then(|&address| address.checked_sub(base)),
+                value,
+                error,
+            }
+        })
+        .collect()
+}
+
+/// Logs one row per signature with one column per build.
+fn log_matrix(report: &HealthReport) {
+    log::info!(
+        "Legend: . unique and resolved, R unresolved, D duplicate, - not found, M module missing"
+    );
+
+    let name_width = report
+        .signatures
+        .iter()
+        .map(|signature| signature.name.len())
+        .max()
+        .unwrap_or(0);
+
+    for signature in &report.signatures {
+        let row: String = signature
+            .results
+            .iter()
+            .map(|result| result.status.symbol())
+            .collect();
+
+        let healthy = signature
+            .results
+            .iter()
+            .filter(|result| result.status == Status::Healthy)
+            .count();
+
+        log::info!(
+            "{:<width$} {} {}/{}",
+            signature.name,
+            row,
+            healthy,
+            signature.results.len(),
+            width = name_width
+        );
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    use crate::config::{Operation, Signature};
+    use crate::remote::BufferMemorySource;
+
+    fn signature(name: &str, module: &str, pattern: &str, operations: Vec<Operation>) -> Signature {
+        Signature {
+            name: name.to_string(),
+            module: module.to_string(),
+            pattern: Some(pattern.to_string()),
+            base: None,
+            window: None,
+            operations,
+        }
+    }
+
+    #[test]
+    fn classify_signatures() -> Result<()> {
+        let mut data = vec![0; 0x1000];
+
+        data[0x100..0x104].copy_from_slice(&[0xE8, 0xCC, 0xCC, 0xE8]);
+        data[0x200..0x203].copy_from_slice(&[0x48, 0x8B, 0x0D]);
+        data[0x300..0x303].copy_from_slice(&[0x48, 0x8B, 0x0D]);
+        data[0x400..0x404].copy_from_slice(&[0x11, 0x22, 0x33, 0x44]);
+
+        let mut source = BufferMemorySource::new();
+
+        source.add_module("client.dll", 0x10000, data);
+
+        let session = Session::new(Process::with_source(source))?;
+
+        let config = Config {
+            signatures: vec![
+                signature("healthy", "client.dll", "E8 CC CC E8", Vec::new()),
+                signature("duplicate", "client.dll", "48 8B 0D", Vec::new()),
+                signature("not_found", "client.dll", "DE AD BE EF", Vec::new()),
+                // Dereferences the zeroed bytes after the match.
+                signature(
+                    "unresolved",
+                    "client.dll",
+                    "11 22 33 44",
+                    vec![
+                        Operation::Add { value: 0x10 },
+                        Operation::Dereference {
+                            times: None,
+                            size: None,
+                        },
+                    ],
+                ),
+                signature("module_missing", "engine2.dll", "E8 CC CC E8", Vec::new()),
+            ],
+        };
+
+        let graph = SignatureGraph::new(&config.signatures)?;
+
+        let results = check_session(&config, &graph, &session);
+
+        let statuses: Vec<Status> = results.iter().map(|result| result.status).collect();
+
+        assert_eq!(
+            statuses,
+            [
+                Status::Healthy,
+                Status::Duplicate,
+                Status::NotFound,
+                Status::Unresolved,
+                Status::ModuleMissing,
+            ]
+        );
+
+        assert_eq!(results[0].rva, Some(0x100));
+        assert_eq!(results[0].value, Some(0x100));
+        assert_eq!(results[1].matches, 2);
+        assert!(results[3].error.is_some());
+
+        Ok(())
+    }
+}
@@ -5,6 +5,7 @@ use serde_json::Error as SerdeError;
 
 use thiserror::Error;
 
+#[cfg(windows)]
 use windows::core::Error as WindowsError;
 
 #[derive(Debug, Error)]
@@ -12,9 +13,18 @@ pub enum Error {
     #[error("Buffer size mismatch: expected {0}, got {1}")]
     BufferSizeMismatch(usize, usize),
 
+    #[error("Cyclic signature dependency: {0}")]
+    CyclicSignature(String),
+
     #[error("Invalid magic: {0:#X}")]
     InvalidMagic(u32),
 
+    #[error("Invalid address: {0:#X}")]
+    InvalidAddress(usize),
+
+    #[error("Invalid pattern: {0}")]
+    InvalidPattern(String),
+
     #[error("IO error: {0}")]
     IOError(#[from] io::Error),
 
@@ -27,12 +37,25 @@ pub enum Error {
     #[error("Process not found")]
     ProcessNotFound,
 
+    #[error("Null pointer at {0:#X}")]
+    NullPointer(usize),
+
     #[error("Serde error: {0}")]
     SerdeError(#[from] SerdeError),
 
+    #[error("Signature not found: {0}")]
+    SignatureNotFound(String),
+
+    #[error("Unsupported: {0}")]
+    Unsupported(&'static str),
+
+    #[error("Base signature not resolved: {0}")]
+    UnresolvedBase(String),
+
     #[error("UTF-8 error: {0}")]
     Utf8Error(#[from] FromUtf8Error),
 
+    #[cfg(windows)]
     #[error("Windows error: {0}")]
     WindowsError(#[from] WindowsError),
 }
@@ -1,46 +1,148 @@
 #![allow(dead_code)]
 
 use std::fs;
+use std::path::PathBuf;
 use std::time::Instant;
 
 use clap::Parser;
 
 use simple_logger::SimpleLogger;
 
+use alloc_stats::Phase;
 use builder::*;
 use dumpers::*;
 use error::Result;
-use remote::Process;
+#[cfg(windows)]
+use remote::LiveMemorySource;
+use remote::{
+    CaptureMemorySource, MemorySource, MinidumpMemorySource, PeMemorySource, Process,
+    RecordingMemorySource, ReplayMemorySource, SnapshotMemorySource,
+};
+use schema::SchemaDatabase;
+use session::Session;
 
+mod alloc_stats;
 mod builder;
 mod config;
 mod dumpers;
 mod error;
 mod mem;
 mod remote;
+mod schema;
 mod sdk;
+mod session;
 
 #[derive(Debug, Parser)]
 #[command(author, version, about, long_about = None)]
 struct Args {
+    /// Add constexpr hash-sorted lookup tables to the generated C++ headers.
+    #[arg(long)]
+    cpp_lookup_tables: bool,
+
+    /// Add packed struct layouts of each class to the generated C++ headers.
+    #[arg(long)]
+    cpp_structs: bool,
+
+    /// Emit typed `Field<T, offset>` descriptors in the generated C++ headers.
+    #[arg(long)]
+    cpp_typed_fields: bool,
+
+    /// Write one C++ header per class, included from an umbrella header per module.
+    #[arg(long)]
+    cpp_split_headers: bool,
+
     #[arg(short, long)]
     interfaces: bool,
 
     #[arg(short, long)]
     offsets: bool,
 
+    /// Emit the fields of each class merged into read spans that skip at most this many bytes.
+    #[arg(long, value_name = "BYTES")]
+    read_span_gap: Option<usize>,
+
+    /// Directory the generated files are written to.
+    #[arg(long, value_name = "DIR", default_value = "generated")]
+    output_dir: PathBuf,
+
+    /// Resolve offsets from the PE files in these directories instead of a running game.
+    #[arg(long, value_name = "DIR")]
+    offline: Vec<PathBuf>,
+
+    /// Write a compressed snapshot of the module images and every page read during the dump.
+    #[arg(long, value_name = "FILE")]
+    capture: Option<PathBuf>,
+
+    /// Read memory from a snapshot written with `--capture` instead of a running game.
+    #[arg(long, value_name = "FILE", conflicts_with_all = ["offline", "minidump", "replay_reads"])]
+    snapshot: Option<PathBuf>,
+
+    /// Record every memory read into a trace file.
+    #[arg(long, value_name = "FILE")]
+    record_reads: Option<PathBuf>,
+
+    /// Read memory from a Windows minidump instead of a running game.
+    #[arg(long, value_name = "FILE", conflicts_with_all = ["offline", "replay_reads"])]
+    minidump: Option<PathBuf>,
+
+    /// Serve memory reads from a trace file recorded with `--record-reads`.
+    #[arg(long, value_name = "FILE", conflicts_with = "offline")]
+    replay_reads: Option<PathBuf>,
+
     #[arg(short, long)]
     schemas: bool,
 
+    /// Check every signature against each build directory in an archive of module builds, then
+    /// exit.
+    #[arg(long, value_name = "DIR")]
+    signature_health: Option<PathBuf>,
+
+    /// Save the schemas read from the game to a cache file.
+    #[arg(long, value_name = "FILE")]
+    save_schemas: Option<PathBuf>,
+
+    /// Render schemas from a cache file written with `--save-schemas` instead of the game.
+    #[arg(long, value_name = "FILE", conflicts_with = "save_schemas")]
+    load_schemas: Option<PathBuf>,
+
     #[arg(short, long)]
     verbose: bool,
 }
 
+#[cfg(windows)]
+fn live_source() -> Result<Box<dyn MemorySource>> {
+    Ok(Box::new(LiveMemorySource::new("cs2.exe")?))
+}
+
+/// Only a running game on Windows can be read directly, everywhere else a file has to be given.
+#[cfg(not(windows))]
+fn live_source() -> Result<Box<dyn MemorySource>> {
+    Err(error::Error::Unsupported(
+        "reading a running game outside Windows, pass --offline, --minidump, --snapshot or \
+         --replay-reads",
+    ))
+}
+
 fn main() -> Result<()> {
     let Args {
+        cpp_lookup_tables,
+        cpp_structs,
+        cpp_typed_fields,
+        cpp_split_headers,
         interfaces,
         offsets,
+        read_span_gap,
+        output_dir,
+        offline,
+        minidump,
+        capture,
+        snapshot,
+        record_reads,
+        replay_reads,
         schemas,
+        signature_health,
+        save_schemas,
+        load_schemas,
         verbose,
     } = Args::parse();
 
@@ -58,34 +160,145 @@ fn main() -> Result<()> {
 
     let start_time = Instant::now();
 
-    let process = Process::new("cs2.exe")?;
+    if let Some(archive) = &signature_health {
+        check_signature_health(archive, &output_dir)?;
 
-    fs::create_dir_all("generated")?;
+        log::info!("Done! Time elapsed: {:?}", start_time.elapsed());
 
-    let mut builders: Vec<FileBuilderEnum> = vec![
-        FileBuilderEnum::CppFileBuilder(CppFileBuilder),
-        FileBuilderEnum::CSharpFileBuilder(CSharpFileBuilder),
-        FileBuilderEnum::JsonFileBuilder(JsonFileBuilder::default()),
-        FileBuilderEnum::RustFileBuilder(RustFileBuilder),
-    ];
+        return Ok(());
+    }
 
     let all = !(interfaces || offsets || schemas);
 
+    // A schema cache holds everything needed to render the schemas, so the game is only touched
+    // if something else was asked for as well.
+    let needs_process = all || interfaces || offsets || load_schemas.is_none();
+
+    let session = if needs_process {
+        let mut source: Box<dyn MemorySource> = if let Some(path) = &replay_reads {
+            Box::new(ReplayMemorySource::new(path)?)
+        } else if let Some(path) = &snapshot {
+            Box::new(SnapshotMemorySource::new(path)?)
+        } else if let Some(path) = &minidump {
+            Box::new(MinidumpMemorySource::new(path)?)
+        } else if !offline.is_empty() {
+            Box::new(PeMemorySource::new(&offline)?)
+        } else {
+            live_source()?
+        };
+
+        // The capture sits below the recorder, so the module images it reads when writing the
+        // snapshot don't end up in the trace.
+        if let Some(path) = &capture {
+            source = Box::new(CaptureMemorySource::new(source, path)?);
+        }
+
+        if let Some(path) = &record_reads {
+            source = Box::new(RecordingMemorySource::new(source, path)?);
+        }
+
+        Some(Session::new(Process::with_source(source))?)
+    } else {
+        None
+    };
+
+    fs::create_dir_all(&output_dir)?;
+    fs::write(output_dir.join("cs2d.hpp"), cs2d_file_builder::CS2D_READER)?;
+
+    // Every dumper runs on its own thread, so each gets its own set of builders.
+    let new_builders = || -> Vec<FileBuilderEnum> {
+        vec![
+            FileBuilderEnum::CppFileBuilder(CppFileBuilder::new(CppFileBuilderOptions {
+                lookup_tables: cpp_lookup_tables,
+                structs: cpp_structs,
+                typed_fields: cpp_typed_fields,
+                split_headers: cpp_split_headers,
+            })),
+            FileBuilderEnum::CppModuleFileBuilder(CppModuleFileBuilder),
+            FileBuilderEnum::Cs2dFileBuilder(Cs2dFileBuilder::default()),
+            FileBuilderEnum::CSharpFileBuilder(CSharpFileBuilder),
+            FileBuilderEnum::JsonFileBuilder(JsonFileBuilder::default()),
+            FileBuilderEnum::RustFileBuilder(RustFileBuilder),
+        ]
+    };
+
+    // Schemas and interfaces are registered by the game at runtime, so the images on disk only
+    // hold what is needed to resolve offsets.
+    if !offline.is_empty() && ((schemas && load_schemas.is_none()) || interfaces) {
+        log::warn!("Schemas and interfaces can only be dumped from a running game, skipping.");
+    }
+
+    let mut tasks: Vec<Task> = Vec::new();
+
     if schemas || all {
-        dump_schemas(&mut builders, &process)?;
+        tasks.push((
+            "schemas",
+            Box::new(|| {
+                let _traversal = alloc_stats::enter(Phase::TypeScopeTraversal);
+
+                let mut builders = new_builders();
+
+                let database = match (&load_schemas, &session) {
+                    (Some(path), _) => {
+                        let database = SchemaDatabase::load(path)?;
+
+                        dump_schemas(&mut builders, &database, read_span_gap, &output_dir)?;
+
+                        database
+                    }
+                    (None, Some(session)) if offline.is_empty() => collect_and_dump_schemas(
+                        &mut builders,
+                        session,
+                        read_span_gap,
+                        &output_dir,
+                    )?,
+                    _ => return Ok(()),
+                };
+
+                if let Some(path) = &save_schemas {
+                    database.save(path)?;
+                }
+
+                Ok(())
+            }),
+        ));
     }
 
-    if interfaces || all {
-        dump_interfaces(&mut builders, &process)?;
+    if let Some(session) = &session {
+        if (interfaces || all) && offline.is_empty() {
+            tasks.push((
+                "interfaces",
+                Box::new(|| {
+                    let _walk = alloc_stats::enter(Phase::InterfaceWalk);
+
+                    dump_interfaces(&mut new_builders(), session, &output_dir)
+                }),
+            ));
+        }
+
+        if offsets || all {
+            tasks.push((
+                "offsets",
+                Box::new(|| {
+                    let _scan = alloc_stats::enter(Phase::ModuleScan);
+
+                    dump_offsets(&mut new_builders(), session, &output_dir)
+                }),
+            ));
+        }
     }
 
-    if offsets || all {
-        dump_offsets(&mut builders, &process)?;
+    run_tasks(tasks)?;
+
+    if let Some(session) = &session {
+        session.log_stats();
     }
 
     let duration = start_time.elapsed();
 
     log::info!("Done! Time elapsed: {:?}", duration);
 
+    alloc_stats::log_report();
+
     Ok(())
 }
@@ -1,3 +1,11 @@
 pub use address::Address;
+pub use byte_reader::ByteReader;
+pub use pattern::Pattern;
+pub use region_map::{MemoryRegion, Protection, RegionMap};
+pub use scanner::Scanner;
 
 pub mod address;
+pub mod byte_reader;
+pub mod pattern;
+pub mod region_map;
+pub mod scanner;
@@ -0,0 +1,103 @@
+use serde::{Deserialize, Serialize};
+
+use crate::error::{Error, Result};
+
+/// A byte pattern such as `48 8B 0D ? ? ? ?`, parsed from and written back to that form when it
+/// is part of `config.json`.
+#[derive(Clone, Debug, Deserialize, PartialEq, Serialize)]
+#[serde(try_from = "String", into = "String")]
+pub struct Pattern {
+    bytes: Vec<Option<u8>>,
+    anchor: usize,
+}
+
+impl Pattern {
+    pub fn new(pattern: &str) -> Result<Self> {
+        let bytes = pattern
+            .split_whitespace()
+            .map(|token| match token {
+                "?" | "??" => Ok(None),
+                _ => u8::from_str_radix(token, 16)
+                    .map(Some)
+                    .map_err(|_| Error::InvalidPattern(pattern.to_string())),
+            })
+            .collect::<Result<Vec<_>>>()?;
+
+        if bytes.is_empty() {
+            return Err(Error::InvalidPattern(pattern.to_string()));
+        }
+
+        // The first concrete byte is used to skip ahead quickly before comparing the rest.
+        let anchor = bytes.iter().position(Option::is_some).unwrap_or(0);
+
+        Ok(Self { bytes, anchor })
+    }
+
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.bytes.len()
+    }
+
+    #[inline]
+    pub fn matches(&self, data: &[u8]) -> bool {
+        data.len() >= self.bytes.len()
+            && self
+                .bytes
+                .iter()
+                .zip(data)
+                .all(|(pattern_byte, byte)| pattern_byte.map_or(true, |value| value == *byte))
+    }
+
+    /// Returns the offsets of every match in `data` that starts at or after `start`.
+    pub fn find_all<'a>(
+        &'a self,
+        data: &'a [u8],
+        start: usize,
+    ) -> impl Iterator<Item = usize> + 'a {
+        let end = (data.len() + 1).saturating_sub(self.bytes.len());
+
+        let mut position = start;
+
+        std::iter::from_fn(move || {
+            while position < end {
+                let candidate = match self.bytes[self.anchor] {
+                    Some(value) => data[position + self.anchor..end + self.anchor]
+                        .iter()
+                        .position(|&byte| byte == value)
+                        .map(|index| position + index)?,
+                    None => position,
+                };
+
+                position = candidate + 1;
+
+                if self.matches(&data[candidate..]) {
+                    return Some(candidate);
+                }
+            }
+
+            None
+        })
+    }
+}
+
+impl TryFrom<String> for Pattern {
+    type Error = Error;
+
+    fn try_from(pattern: String) -> Result<Self> {
+        Self::new(&pattern)
+    }
+}
+
+impl From<Pattern> for String {
+    fn from(pattern: Pattern) -> Self {
+        pattern
+            .bytes
+            .iter()
+            .map(|byte| match byte {
+                Some(value) => format!("{:02X}", value),
+                None => "?".to_string(),
+            })
+            .collect::<Vec<_>>()
+            .join(" ")
+    }
+}
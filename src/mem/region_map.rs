@@ -0,0 +1,172 @@
+use std::ops::BitOr;
+
+#[derive(Clone, Copy, Debug, Default, Eq, PartialEq)]
+pub struct Protection(u8);
+
+impl Protection {
+    pub const NONE: Self = Self(0);
+    pub const READ: Self = Self(1 << 0);
+    pub const WRITE: Self = Self(1 << 1);
+    pub const EXECUTE: Self = Self(1 << 2);
+
+    #[inline]
+    pub fn bits(self) -> u8 {
+        self.0
+    }
+
+    #[inline]
+    pub fn from_bits(bits: u8) -> Self {
+        Self(bits & (Self::READ | Self::WRITE | Self::EXECUTE).0)
+    }
+
+    #[inline]
+    pub fn contains(self, other: Self) -> bool {
+        self.0 & other.0 == other.0
+    }
+}
+
+impl BitOr for Protection {
+    type Output = Self;
+
+    fn bitor(self, rhs: Self) -> Self::Output {
+        Self(self.0 | rhs.0)
+    }
+}
+
+#[derive(Clone, Copy, Debug, Eq, PartialEq)]
+pub struct MemoryRegion {
+    pub start: usize,
+    pub end: usize,
+    pub protection: Protection,
+}
+
+/// Sorted, non-overlapping memory regions of a process, used to reject reads that are bound to
+/// fail before they reach the memory source.
+#[derive(Debug, Default)]
+pub struct RegionMap {
+    regions: Vec<MemoryRegion>,
+}
+
+impl RegionMap {
+    pub fn new(mut regions: Vec<MemoryRegion>) -> Self {
+        regions.retain(|region| region.start < region.end);
+        regions.sort_by_key(|region| region.start);
+
+        Self { regions }
+    }
+
+    #[inline]
+    pub fn regions(&self) -> &[MemoryRegion] {
+        &self.regions
+    }
+
+    pub fn find(&self, address: usize) -> Option<&MemoryRegion> {
+        let index = self
+            .regions
+            .partition_point(|region| region.start <= address);
+
+        index
+            .checked_sub(1)
+            .map(|index| &self.regions[index])
+            .filter(|region| address < region.end)
+    }
+
+    #[inline]
+    pub fn is_readable(&self, address: usize, size: usize) -> bool {
+        self.readable_len(address, size) == size
+    }
+
+    /// Returns how many bytes starting at `address`, up to `size`, can be read without crossing
+    /// into an unreadable or unmapped page.
+    pub fn readable_len(&self, address: usize, size: usize) -> usize {
+        let end = address.saturating_add(size);
+
+        let mut current = address;
+
+        let index = self
+            .regions
+            .partition_point(|region| region.start <= address);
+
+        for region in self.regions[index.saturating_sub(1)..].iter() {
+            if current >= end
+                || region.start > current
+                || !region.protection.contains(Protection::READ)
+            {
+                break;
+            }
+
+            current = current.max(region.end.min(end));
+        }
+
+        current.min(end) - address
+    }
+
+    /// Returns the contiguous readable ranges that intersect `[start, end)`.
+    pub fn readable_ranges(&self, start: usize, end: usize) -> Vec<(usize, usize)> {
+        let mut ranges: Vec<(usize, usize)> = Vec::new();
+
+        for region in &self.regions {
+            if region.end <= start || region.start >= end {
+                continue;
+            }
+
+            if !region.protection.contains(Protection::READ) {
+                continue;
+            }
+
+            let range = (region.start.max(start), region.end.min(end));
+
+            match ranges.last_mut() {
+                Some(last) if last.1 == range.0 => last.1 = range.1,
+                _ => ranges.push(range),
+            }
+        }
+
+        ranges
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn region(start: usize, end: usize, protection: Protection) -> MemoryRegion {
+        MemoryRegion {
+            start,
+            end,
+            protection,
+        }
+    }
+
+    #[test]
+    fn readable_len() {
+        let map = RegionMap::new(vec![
+            region(0x3000, 0x4000, Protection::NONE),
+            region(0x1000, 0x2000, Protection::READ),
+            region(0x2000, 0x3000, Protection::READ | Protection::WRITE),
+        ]);
+
+        assert_eq!(map.readable_len(0x1800, 0x1000), 0x1000);
+        assert_eq!(map.readable_len(0x2800, 0x1000), 0x800);
+        assert_eq!(map.readable_len(0x3800, 0x10), 0);
+        assert_eq!(map.readable_len(0x800, 0x10), 0);
+
+        assert!(map.is_readable(0x1000, 0x2000));
+        assert!(!map.is_readable(0x1000, 0x2001));
+    }
+
+    #[test]
+    fn readable_ranges() {
+        let map = RegionMap::new(vec![
+            region(0x1000, 0x2000, Protection::READ),
+            region(0x2000, 0x3000, Protection::READ | Protection::EXECUTE),
+            region(0x3000, 0x4000, Protection::NONE),
+            region(0x5000, 0x6000, Protection::READ),
+        ]);
+
+        assert_eq!(
+            map.readable_ranges(0x1800, 0x5800),
+            vec![(0x1800, 0x3000), (0x5000, 0x5800)]
+        );
+    }
+}
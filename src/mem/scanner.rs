@@ -0,0 +1,175 @@
+use super::Pattern;
+
+pub const SCAN_CHUNK_SIZE: usize = 0x100000;
+
+const PAGE_SIZE: usize = 0x1000;
+
+/// Scans a memory range for several patterns at once while holding only one chunk in memory.
+///
+/// The last `longest pattern - 1` bytes of every chunk are carried over to the next one, so
+/// matches that straddle a chunk boundary are still found, and each match is reported once.
+pub struct Scanner<'a> {
+    patterns: &'a [Pattern],
+    max_matches: usize,
+    matches: Vec<Vec<usize>>,
+    overlap: usize,
+    buffer: Vec<u8>,
+    carried: usize,
+    carried_address: usize,
+}
+
+impl<'a> Scanner<'a> {
+    pub fn new(patterns: &'a [Pattern], max_matches: usize) -> Self {
+        let overlap = patterns.iter().map(Pattern::len).max().unwrap_or(1) - 1;
+
+        Self {
+            patterns,
+            max_matches,
+            matches: vec![Vec::new(); patterns.len()],
+            overlap,
+            buffer: vec![0; SCAN_CHUNK_SIZE + overlap],
+            carried: 0,
+            carried_address: 0,
+        }
+    }
+
+    pub fn is_done(&self) -> bool {
+        self.matches
+            .iter()
+            .all(|matches| matches.len() >= self.max_matches)
+    }
+
+    /// Scans `size` bytes starting at `start`, reading through `read`.
+    ///
+    /// A chunk that fails to read is retried page by page, so uncommitted or guarded pages are
+    /// skipped without losing the rest of the chunk.
+    pub fn scan<F>(&mut self, start: usize, size: usize, mut read: F)
+    where
+        F: FnMut(usize, &mut [u8]) -> bool,
+    {
+        let end = start + size;
+
+        let mut address = start;
+
+        while address < end && !self.is_done() {
+            let len = SCAN_CHUNK_SIZE.min(end - address);
+
+            if self.read_into(address, len, &mut read) {
+                self.feed(address, len);
+            } else {
+                let chunk_end = address + len;
+
+                let mut page = address;
+
+                while page < chunk_end {
+                    let page_len = (PAGE_SIZE - page % PAGE_SIZE).min(chunk_end - page);
+
+                    if self.read_into(page, page_len, &mut read) {
+                        self.feed(page, page_len);
+                    } else {
+                        self.carried = 0;
+                    }
+
+                    page += page_len;
+                }
+            }
+
+            address += len;
+        }
+    }
+
+    pub fn into_matches(self) -> Vec<Vec<usize>> {
+        self.matches
+    }
+
+    fn read_into<F>(&mut self, address: usize, len: usize, read: &mut F) -> bool
+    where
+        F: FnMut(usize, &mut [u8]) -> bool,
+    {
+        if self.carried_address + self.carried != address {
+            self.carried = 0;
+        }
+
+        read(address, &mut self.buffer[self.carried..self.carried + len])
+    }
+
+    fn feed(&mut self, address: usize, len: usize) {
+        let total = self.carried + len;
+        let base = address - self.carried;
+
+        let data = &self.buffer[..total];
+
+        for (pattern, matches) in self.patterns.iter().zip(self.matches.iter_mut()) {
+            if matches.len() >= self.max_matches {
+                continue;
+            }
+
+            // Matches that fit entirely inside the carried bytes were reported by the last chunk.
+            let first = (self.carried + 1).saturating_sub(pattern.len());
+
+            for offset in pattern.find_all(data, first) {
+                matches.push(base + offset);
+
+                if matches.len() >= self.max_matches {
+                    break;
+                }
+            }
+        }
+
+        let keep = self.overlap.min(total);
+
+        self.buffer.copy_within(total - keep..total, 0);
+
+        self.carried = keep;
+        self.carried_address = base + total - keep;
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn scan(memory: &[u8], unreadable: Option<usize>, patterns: &[&str]) -> Vec<Vec<usize>> {
+        let patterns: Vec<Pattern> = patterns.iter().map(|p| Pattern::new(p).unwrap()).collect();
+
+        let mut scanner = Scanner::new(&patterns, usize::MAX);
+
+        scanner.scan(0, memory.len(), |address, buffer| {
+            let end = address + buffer.len();
+
+            if unreadable.map_or(false, |page| address < page + PAGE_SIZE && page < end) {
+                return false;
+            }
+
+            buffer.copy_from_slice(&memory[address..end]);
+
+            true
+        });
+
+        scanner.into_matches()
+    }
+
+    #[test]
+    fn match_across_chunk_boundary() {
+        let mut memory = vec![0; SCAN_CHUNK_SIZE * 2];
+
+        memory[SCAN_CHUNK_SIZE - 2..SCAN_CHUNK_SIZE + 2].copy_from_slice(&[0x48, 0x8B, 0x0D, 0xFF]);
+
+        let matches = scan(&memory, None, &["48 8B 0D ?", "0D FF"]);
+
+        assert_eq!(matches[0], vec![SCAN_CHUNK_SIZE - 2]);
+        assert_eq!(matches[1], vec![SCAN_CHUNK_SIZE]);
+    }
+
+    #[test]
+    fn skip_unreadable_page() {
+        let mut memory = vec![0; SCAN_CHUNK_SIZE];
+
+        memory[0x1000..0x1002].copy_from_slice(&[0xE8, 0xCC]);
+        memory[0x3000..0x3002].copy_from_slice(&[0xE8, 0xCC]);
+
+        let matches = scan(&memory, Some(0x1000), &["E8 CC"]);
+
+        assert_eq!(matches[0], vec![0x3000]);
+    }
+}
@@ -0,0 +1,67 @@
+use crate::error::{Error, Result};
+use crate::mem::{MemoryRegion, Protection};
+
+use super::{MemorySource, ModuleEntry};
+
+/// Serves reads from buffers held in memory, each placed at a fixed address.
+#[derive(Debug, Default)]
+pub struct BufferMemorySource {
+    buffers: Vec<(usize, Vec<u8>)>,
+    modules: Vec<ModuleEntry>,
+}
+
+impl BufferMemorySource {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    pub fn add_buffer(&mut self, base: usize, data: Vec<u8>) {
+        let index = self.buffers.partition_point(|&(start, _)| start < base);
+
+        self.buffers.insert(index, (base, data));
+    }
+
+    pub fn add_module(&mut self, name: &str, base: usize, image: Vec<u8>) {
+        self.modules.push(ModuleEntry {
+            name: name.to_string(),
+            base,
+            size: image.len(),
+        });
+
+        self.add_buffer(base, image);
+    }
+}
+
+impl MemorySource for BufferMemorySource {
+    fn read_memory(&self, address: usize, buffer: &mut [u8]) -> Result<()> {
+        let index = self.buffers.partition_point(|&(start, _)| start <= address);
+
+        let (start, data) = index
+            .checked_sub(1)
+            .map(|index| &self.buffers[index])
+            .filter(|(start, data)| address + buffer.len() <= start + data.len())
+            .ok_or(Error::InvalidAddress(address))?;
+
+        let offset = address - start;
+
+        buffer.copy_from_slice(&data[offset..offset + buffer.len()]);
+
+        Ok(())
+    }
+
+    fn modules(&self) -> Result<Vec<ModuleEntry>> {
+        Ok(self.modules.clone())
+    }
+
+    fn regions(&self) -> Result<Vec<MemoryRegion>> {
+        Ok(self
+            .buffers
+            .iter()
+            .map(|(start, data)| MemoryRegion {
+                start: *start,
+                end: start + data.len(),
+                protection: Protection::READ | Protection::WRITE,
+            })
+            .collect())
+    }
+}
@@ -0,0 +1,225 @@
+use std::collections::HashSet;
+use std::fs::{File, OpenOptions};
+use std::io::{BufWriter, Seek, Write};
+use std::path::{Path, PathBuf};
+use std::sync::Mutex;
+
+use crate::error::Result;
+use crate::mem::{MemoryRegion, Protection, RegionMap};
+
+use super::{MemorySource, ModuleEntry};
+
+pub const SNAPSHOT_MAGIC: &[u8; 8] = b"CS2SNAP\0";
+pub const SNAPSHOT_VERSION: u32 = 1;
+
+/// Size of the footer at the end of a snapshot: the index offset and the trailing magic.
+pub const SNAPSHOT_FOOTER_SIZE: usize = 8 + SNAPSHOT_MAGIC.len();
+
+/// Largest amount of memory compressed into a single block.
+pub const SNAPSHOT_BLOCK_SIZE: usize = 0x40000;
+
+const PAGE_SIZE: usize = 0x1000;
+
+const COMPRESSION_LEVEL: i32 = 3;
+
+/// Forwards every call to another source and writes a snapshot of the process when dropped.
+///
+/// The snapshot holds every module image plus each page outside of them that was read through
+/// this source, which covers the heap reachable from the schema system and interface registries
+/// after a dump. Memory is stored in independently compressed zstd blocks followed by an index,
+/// so `SnapshotMemorySource` only decompresses the blocks a read touches.
+pub struct CaptureMemorySource {
+    inner: Box<dyn MemorySource>,
+    path: PathBuf,
+    pages: Mutex<HashSet<usize>>,
+}
+
+struct Block {
+    address: usize,
+    size: usize,
+    protection: Protection,
+    data_offset: u64,
+    compressed_size: usize,
+}
+
+impl CaptureMemorySource {
+    pub fn new(inner: Box<dyn MemorySource>, path: &Path) -> Result<Self> {
+        // Fail early rather than after the dump if the snapshot can't be written, but leave an
+        // existing snapshot intact until the dump has run.
+        OpenOptions::new().write(true).create(true).open(path)?;
+
+        Ok(Self {
+            inner,
+            path: path.to_path_buf(),
+            pages: Mutex::new(HashSet::new()),
+        })
+    }
+
+    /// Returns the sorted, non-overlapping ranges to capture.
+    fn ranges(&self, modules: &[ModuleEntry]) -> Vec<(usize, usize)> {
+        let mut ranges: Vec<(usize, usize)> = modules
+            .iter()
+            .map(|module| (module.base, module.base + module.size))
+            .collect();
+
+        ranges.extend(
+            self.pages
+                .lock()
+                .unwrap()
+                .iter()
+                .map(|&page| (page, page + PAGE_SIZE)),
+        );
+
+        ranges.sort_unstable();
+
+        let mut merged: Vec<(usize, usize)> = Vec::with_capacity(ranges.len());
+
+        for (start, end) in ranges {
+            match merged.last_mut() {
+                Some(last) if start <= last.1 => last.1 = last.1.max(end),
+                _ => merged.push((start, end)),
+            }
+        }
+
+        merged
+    }
+
+    fn finish(&mut self) -> Result<()> {
+        let modules = self.inner.modules()?;
+        let regions = self.inner.regions().ok().map(RegionMap::new);
+
+        let mut writer = BufWriter::new(File::create(&self.path)?);
+
+        writer.write_all(SNAPSHOT_MAGIC)?;
+        writer.write_all(&SNAPSHOT_VERSION.to_le_bytes())?;
+
+        let mut blocks: Vec<Block> = Vec::new();
+
+        let mut buffer = vec![0; SNAPSHOT_BLOCK_SIZE];
+
+        let mut captured_bytes = 0;
+
+        for (start, end) in self.ranges(&modules) {
+            let ranges = match &regions {
+                Some(regions) => regions.readable_ranges(start, end),
+                None => vec![(start, end)],
+            };
+
+            for (start, end) in ranges {
+                let mut address = start;
+
+                while address < end {
+                    let mut size = SNAPSHOT_BLOCK_SIZE.min(end - address);
+
+                    // Unreadable pages are left out, the rest of the chunk is still captured.
+                    if self
+                        .inner
+                        .read_memory(address, &mut buffer[..size])
+                        .is_err()
+                    {
+                        size = PAGE_SIZE - address % PAGE_SIZE;
+
+                        if self
+                            .inner
+                            .read_memory(address, &mut buffer[..size])
+                            .is_err()
+                        {
+                            address += size;
+
+                            continue;
+                        }
+                    }
+
+                    let compressed = zstd::bulk::compress(&buffer[..size], COMPRESSION_LEVEL)?;
+
+                    let protection = regions
+                        .as_ref()
+                        .and_then(|regions| regions.find(address))
+                        .map_or(Protection::READ, |region| region.protection);
+
+                    blocks.push(Block {
+                        address,
+                        size,
+                        protection,
+                        data_offset: writer.stream_position()?,
+                        compressed_size: compressed.len(),
+                    });
+
+                    writer.write_all(&compressed)?;
+
+                    captured_bytes += size;
+                    address += size;
+                }
+            }
+        }
+
+        let index_offset = writer.stream_position()?;
+
+        writer.write_all(&(modules.len() as u32).to_le_bytes())?;
+
+        for module in &modules {
+            writer.write_all(&(module.name.len() as u16).to_le_bytes())?;
+            writer.write_all(module.name.as_bytes())?;
+            writer.write_all(&(module.base as u64).to_le_bytes())?;
+            writer.write_all(&(module.size as u64).to_le_bytes())?;
+        }
+
+        writer.write_all(&(blocks.len() as u32).to_le_bytes())?;
+
+        for block in &blocks {
+            writer.write_all(&(block.address as u64).to_le_bytes())?;
+            writer.write_all(&(block.size as u32).to_le_bytes())?;
+            writer.write_all(&[block.protection.bits()])?;
+            writer.write_all(&block.data_offset.to_le_bytes())?;
+            writer.write_all(&(block.compressed_size as u32).to_le_bytes())?;
+        }
+
+        writer.write_all(&index_offset.to_le_bytes())?;
+        writer.write_all(SNAPSHOT_MAGIC)?;
+
+        writer.flush()?;
+
+        log::info!(
+            "Captured {} bytes in {} blocks ({} bytes compressed).",
+            captured_bytes,
+            blocks.len(),
+            index_offset
+        );
+
+        Ok(())
+    }
+}
+
+impl MemorySource for CaptureMemorySource {
+    fn read_memory(&self, address: usize, buffer: &mut [u8]) -> Result<()> {
+        self.inner.read_memory(address, buffer)?;
+
+        if !buffer.is_empty() {
+            let first = address / PAGE_SIZE;
+            let last = (address + buffer.len() - 1) / PAGE_SIZE;
+
+            self.pages
+                .lock()
+                .unwrap()
+                .extend((first..=last).map(|page| page * PAGE_SIZE));
+        }
+
+        Ok(())
+    }
+
+    fn modules(&self) -> Result<Vec<ModuleEntry>> {
+        self.inner.modules()
+    }
+
+    fn regions(&self) -> Result<Vec<MemoryRegion>> {
+        self.inner.regions()
+    }
+}
+
+impl Drop for CaptureMemorySource {
+    fn drop(&mut self) {
+        if let Err(e) = self.finish() {
+            log::error!("Failed to write snapshot: {}", e);
+        }
+    }
+}
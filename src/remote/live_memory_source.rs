@@ -0,0 +1,203 @@
+use std::ffi::CStr;
+use std::mem;
+use std::ptr;
+
+use windows::Win32::Foundation::*;
+use windows::Win32::System::Diagnostics::Debug::*;
+use windows::Win32::System::Diagnostics::ToolHelp::*;
+use windows::Win32::System::Memory::*;
+use windows::Win32::System::Threading::*;
+
+use crate::error::{Error, Result};
+use crate::mem::{MemoryRegion, Protection};
+
+use super::{MemorySource, ModuleEntry};
+
+#[derive(Debug)]
+pub struct LiveMemorySource {
+    process_id: u32,
+    process_handle: HANDLE,
+}
+
+impl LiveMemorySource {
+    pub fn new(process_name: &str) -> Result<Self> {
+        let process_id = Self::get_process_id_by_name(process_name)?;
+
+        let process_handle = unsafe { OpenProcess(PROCESS_ALL_ACCESS, false, process_id) }?;
+
+        Ok(Self {
+            process_id,
+            process_handle,
+        })
+    }
+
+    fn get_process_id_by_name(process_name: &str) -> Result<u32> {
+        let snapshot = unsafe { CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0) }?;
+
+        let mut entry = PROCESSENTRY32 {
+            dwSize: mem::size_of::<PROCESSENTRY32>() as u32,
+            ..Default::default()
+        };
+
+        unsafe {
+            Process32First(snapshot, &mut entry)?;
+
+            while Process32Next(snapshot, &mut entry).is_ok() {
+                let name = CStr::from_ptr(&entry.szExeFile as *const _ as *const _)
+                    .to_string_lossy()
+                    .into_owned();
+
+                if name == process_name {
+                    return Ok(entry.th32ProcessID);
+                }
+            }
+        }
+
+        Err(Error::ProcessNotFound)
+    }
+
+    fn protection(flags: PAGE_PROTECTION_FLAGS) -> Protection {
+        if flags.0 & (PAGE_GUARD.0 | PAGE_NOACCESS.0) != 0 {
+            return Protection::NONE;
+        }
+
+        let mut protection = Protection::NONE;
+
+        if flags.0
+            & (PAGE_READONLY.0
+                | PAGE_READWRITE.0
+                | PAGE_WRITECOPY.0
+                | PAGE_EXECUTE_READ.0
+                | PAGE_EXECUTE_READWRITE.0
+                | PAGE_EXECUTE_WRITECOPY.0)
+            != 0
+        {
+            protection = protection | Protection::READ;
+        }
+
+        if flags.0
+            & (PAGE_READWRITE.0
+                | PAGE_WRITECOPY.0
+                | PAGE_EXECUTE_READWRITE.0
+                | PAGE_EXECUTE_WRITECOPY.0)
+            != 0
+        {
+            protection = protection | Protection::WRITE;
+        }
+
+        if flags.0
+            & (PAGE_EXECUTE.0
+                | PAGE_EXECUTE_READ.0
+                | PAGE_EXECUTE_READWRITE.0
+                | PAGE_EXECUTE_WRITECOPY.0)
+            != 0
+        {
+            protection = protection | Protection::EXECUTE;
+        }
+
+        protection
+    }
+}
+
+impl MemorySource for LiveMemorySource {
+    fn read_memory(&self, address: usize, buffer: &mut [u8]) -> Result<()> {
+        unsafe {
+            ReadProcessMemory(
+                self.process_handle,
+                address as *const _,
+                buffer.as_mut_ptr() as *mut _,
+                buffer.len(),
+                Some(ptr::null_mut()),
+            )
+        }
+        .map_err(Into::into)
+    }
+
+    fn write_memory(&self, address: usize, buffer: &[u8]) -> Result<()> {
+        unsafe {
+            WriteProcessMemory(
+                self.process_handle,
+                address as *const _,
+                buffer.as_ptr() as *const _,
+                buffer.len(),
+                Some(ptr::null_mut()),
+            )
+        }
+        .map_err(Into::into)
+    }
+
+    fn modules(&self) -> Result<Vec<ModuleEntry>> {
+        let snapshot = unsafe { CreateToolhelp32Snapshot(TH32CS_SNAPMODULE, self.process_id) }?;
+
+        let mut entry = MODULEENTRY32 {
+            dwSize: mem::size_of::<MODULEENTRY32>() as u32,
+            ..Default::default()
+        };
+
+        let mut modules = Vec::new();
+
+        unsafe {
+            Module32First(snapshot, &mut entry)?;
+
+            while Module32Next(snapshot, &mut entry).is_ok() {
+                let name = CStr::from_ptr(&entry.szModule as *const _ as *const _)
+                    .to_string_lossy()
+                    .into_owned();
+
+                modules.push(ModuleEntry {
+                    name,
+                    base: entry.modBaseAddr as usize,
+                    size: entry.modBaseSize as usize,
+                });
+            }
+        }
+
+        Ok(modules)
+    }
+
+    fn regions(&self) -> Result<Vec<MemoryRegion>> {
+        let mut regions = Vec::new();
+
+        let mut address: usize = 0;
+
+        loop {
+            let mut info = MEMORY_BASIC_INFORMATION::default();
+
+            let written = unsafe {
+                VirtualQueryEx(
+                    self.process_handle,
+                    Some(address as *const _),
+                    &mut info,
+                    mem::size_of::<MEMORY_BASIC_INFORMATION>(),
+                )
+            };
+
+            if written == 0 || info.RegionSize == 0 {
+                break;
+            }
+
+            let start = info.BaseAddress as usize;
+            let end = start + info.RegionSize;
+
+            if info.State == MEM_COMMIT {
+                regions.push(MemoryRegion {
+                    start,
+                    end,
+                    protection: Self::protection(info.Protect),
+                });
+            }
+
+            address = end;
+        }
+
+        Ok(regions)
+    }
+}
+
+impl Drop for LiveMemorySource {
+    fn drop(&mut self) {
+        if !self.process_handle.is_invalid() {
+            unsafe { CloseHandle(self.process_handle).unwrap() }
+        }
+    }
+}
@@ -0,0 +1,41 @@
+use crate::error::{Error, Result};
+use crate::mem::MemoryRegion;
+
+#[derive(Clone, Debug)]
+pub struct ModuleEntry {
+    pub name: String,
+    pub base: usize,
+    pub size: usize,
+}
+
+pub trait MemorySource: Send + Sync {
+    fn read_memory(&self, address: usize, buffer: &mut [u8]) -> Result<()>;
+
+    fn write_memory(&self, _address: usize, _buffer: &[u8]) -> Result<()> {
+        Err(Error::Unsupported("writing memory"))
+    }
+
+    fn modules(&self) -> Result<Vec<ModuleEntry>>;
+
+    fn regions(&self) -> Result<Vec<MemoryRegion>> {
+        Err(Error::Unsupported("querying memory regions"))
+    }
+}
+
+impl<S: MemorySource + ?Sized> MemorySource for Box<S> {
+    fn read_memory(&self, address: usize, buffer: &mut [u8]) -> Result<()> {
+        (**self).read_memory(address, buffer)
+    }
+
+    fn write_memory(&self, address: usize, buffer: &[u8]) -> Result<()> {
+        (**self).write_memory(address, buffer)
+    }
+
+    fn modules(&self) -> Result<Vec<ModuleEntry>> {
+        (**self).modules()
+    }
+
+    fn regions(&self) -> Result<Vec<MemoryRegion>> {
+        (**self).regions()
+    }
+}
@@ -0,0 +1,305 @@
+use std::fs::File;
+use std::path::Path;
+
+use memmap2::Mmap;
+
+use crate::error::{Error, Result};
+use crate::mem::{ByteReader, MemoryRegion, Protection};
+
+use super::{MemorySource, ModuleEntry};
+
+const MINIDUMP_SIGNATURE: u32 = 0x504D444D; // "MDMP"
+
+const MODULE_LIST_STREAM: u32 = 4;
+const MEMORY_LIST_STREAM: u32 = 5;
+const MEMORY64_LIST_STREAM: u32 = 9;
+
+const MODULE_SIZE: usize = 108;
+
+struct Range {
+    start: usize,
+    end: usize,
+    data_offset: usize,
+}
+
+impl Range {
+    fn new(start: usize, size: usize, data_offset: usize) -> Result<Self> {
+        let end = start
+            .checked_add(size)
+            .ok_or(Error::InvalidAddress(start))?;
+
+        Ok(Self {
+            start,
+            end,
+            data_offset,
+        })
+    }
+}
+
+/// Serves reads from a Windows minidump.
+///
+/// The file is memory-mapped and only its stream directory, module list and memory lists are
+/// parsed, so multi-gigabyte full-memory dumps are never loaded into RAM. Reads are copied
+/// straight out of the mapping.
+pub struct MinidumpMemorySource {
+    data: Mmap,
+    ranges: Vec<Range>,
+    modules: Vec<ModuleEntry>,
+}
+
+impl MinidumpMemorySource {
+    pub fn new(path: &Path) -> Result<Self> {
+        let file = File::open(path)?;
+
+        let data = unsafe { Mmap::map(&file) }?;
+
+        let mut reader = ByteReader::new(&data);
+
+        let signature = reader.u32()?;
+
+        if signature != MINIDUMP_SIGNATURE {
+            return Err(Error::InvalidMagic(signature));
+        }
+
+        reader.position = 8;
+
+        let stream_count = reader.u32()?;
+
+        reader.position = reader.u32()? as usize;
+
+        let mut streams: Vec<(u32, usize)> = Vec::new();
+
+        for _ in 0..stream_count {
+            let stream_type = reader.u32()?;
+
+            reader.position += 4;
+
+            streams.push((stream_type, reader.u32()? as usize));
+        }
+
+        let mut ranges: Vec<Range> = Vec::new();
+        let mut modules: Vec<ModuleEntry> = Vec::new();
+
+        for (stream_type, rva) in streams {
+            reader.position = rva;
+
+            match stream_type {
+                MODULE_LIST_STREAM => {
+                    for i in 0..reader.u32()? as usize {
+                        modules.push(Self::read_module(&data, rva + 4 + i * MODULE_SIZE)?);
+                    }
+                }
+                MEMORY_LIST_STREAM => {
+                    for _ in 0..reader.u32()? {
+                        let start = reader.u64()? as usize;
+                        let size = reader.u32()? as usize;
+                        let data_offset = reader.u32()? as usize;
+
+                        ranges.push(Range::new(start, size, data_offset)?);
+                    }
+                }
+                MEMORY64_LIST_STREAM => {
+                    let count = reader.u64()?;
+
+                    // The memory of all ranges is stored back to back from a single offset.
+                    let mut data_offset = reader.u64()? as usize;
+
+                    for _ in 0..count {
+                        let start = reader.u64()? as usize;
+                        let size = reader.u64()? as usize;
+
+                        ranges.push(Range::new(start, size, data_offset)?);
+
+                        data_offset = data_offset.saturating_add(size);
+                    }
+                }
+                _ => {}
+            }
+        }
+
+        for range in &ranges {
+            let end = range.data_offset.saturating_add(range.end - range.start);
+
+            if end > data.len() {
+                return Err(Error::BufferSizeMismatch(end, data.len()));
+            }
+        }
+
+        ranges.retain(|range| range.start < range.end);
+        ranges.sort_by_key(|range| range.start);
+
+        if modules.is_empty() {
+            return Err(Error::ModuleNotFound);
+        }
+
+        Ok(Self {
+            data,
+            ranges,
+            modules,
+        })
+    }
+
+    fn read_module(data: &[u8], offset: usize) -> Result<ModuleEntry> {
+        let mut reader = ByteReader::new(data);
+
+        reader.position = offset;
+
+        let base = reader.u64()? as usize;
+        let size = reader.u32()? as usize;
+
+        reader.position = offset + 20;
+        reader.position = reader.u32()? as usize;
+
+        let name_len = reader.u32()? as usize;
+
+        let name: Vec<u16> = reader
+            .bytes(name_len)?
+            .chunks_exact(2)
+            .map(|c| u16::from_le_bytes([c[0], c[1]]))
+            .collect();
+
+        let path = String::from_utf16_lossy(&name);
+
+        // Modules are listed by full path, but looked up by file name.
+        let name = path.rsplit(['\\', '/']).next().unwrap_or(&path).to_string();
+
+        Ok(ModuleEntry { name, base, size })
+    }
+}
+
+impl MemorySource for MinidumpMemorySource {
+    fn read_memory(&self, address: usize, buffer: &mut [u8]) -> Result<()> {
+        let mut index = self.ranges.partition_point(|range| range.end <= address);
+
+        let mut position = 0;
+
+        // A read may span several adjacent ranges, but never a gap between them.
+        while position < buffer.len() {
+            let current = address + position;
+
+            let range = self
+                .ranges
+                .get(index)
+                .filter(|range| range.start <= current)
+                .ok_or(Error::InvalidAddress(current))?;
+
+            let len = (range.end - current).min(buffer.len() - position);
+
+            let offset = range.data_offset + (current - range.start);
+
+            buffer[position..position + len].copy_from_slice(&self.data[offset..offset + len]);
+
+            position += len;
+            index += 1;
+        }
+
+        Ok(())
+    }
+
+    fn modules(&self) -> Result<Vec<ModuleEntry>> {
+        Ok(self.modules.clone())
+    }
+
+    fn regions(&self) -> Result<Vec<MemoryRegion>> {
+        Ok(self
+            .ranges
+            .iter()
+            .map(|range| MemoryRegion {
+                start: range.start,
+                end: range.end,
+                protection: Protection::READ,
+            })
+            .collect())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    use std::fs;
+
+    fn push_u32(data: &mut Vec<u8>, value: u32) {
+        data.extend_from_slice(&value.to_le_bytes());
+    }
+
+    fn push_u64(data: &mut Vec<u8>, value: u64) {
+        data.extend_from_slice(&value.to_le_bytes());
+    }
+
+    #[test]
+    fn read_minidump() -> Result<()> {
+        let mut data = Vec::new();
+
+        // Header with 2 streams, directory right after it.
+        push_u32(&mut data, MINIDUMP_SIGNATURE);
+        push_u32(&mut data, 0xA793);
+        push_u32(&mut data, 2);
+        push_u32(&mut data, 32);
+        data.resize(32, 0);
+
+        let module_list = 32 + 2 * 12;
+        let name = module_list + 4 + MODULE_SIZE;
+        let name_bytes: Vec<u8> = "C:\\game\\bin\\client.dll"
+            .encode_utf16()
+            .flat_map(u16::to_le_bytes)
+            .collect();
+        let memory_list = name + 4 + name_bytes.len();
+
+        push_u32(&mut data, MODULE_LIST_STREAM);
+        push_u32(&mut data, (4 + MODULE_SIZE) as u32);
+        push_u32(&mut data, module_list as u32);
+
+        push_u32(&mut data, MEMORY64_LIST_STREAM);
+        push_u32(&mut data, 16 + 2 * 16);
+        push_u32(&mut data, memory_list as u32);
+
+        push_u32(&mut data, 1);
+        push_u64(&mut data, 0x10000);
+        push_u32(&mut data, 0x3000);
+        data.resize(module_list + 4 + 20, 0);
+        push_u32(&mut data, name as u32);
+        data.resize(name, 0);
+
+        push_u32(&mut data, name_bytes.len() as u32);
+        data.extend_from_slice(&name_bytes);
+
+        let memory = memory_list + 16 + 2 * 16;
+
+        push_u64(&mut data, 2);
+        push_u64(&mut data, memory as u64);
+        push_u64(&mut data, 0x11000);
+        push_u64(&mut data, 0x1000);
+        push_u64(&mut data, 0x10000);
+        push_u64(&mut data, 0x1000);
+
+        data.extend((0..0x2000).map(|i| (i / 0x1000) as u8 + 1));
+
+        let path = std::env::temp_dir().join(format!("cs2-dumper-{}.dmp", std::process::id()));
+
+        fs::write(&path, &data)?;
+
+        let source = MinidumpMemorySource::new(&path)?;
+
+        let modules = source.modules()?;
+
+        assert_eq!(modules.len(), 1);
+        assert_eq!(modules[0].name, "client.dll");
+        assert_eq!((modules[0].base, modules[0].size), (0x10000, 0x3000));
+
+        // Ranges are sorted, and reads across adjacent ranges are stitched together.
+        let mut buffer = [0; 4];
+
+        source.read_memory(0x10FFE, &mut buffer)?;
+
+        assert_eq!(buffer, [2, 2, 1, 1]);
+
+        assert!(source.read_memory(0x11FFE, &mut buffer).is_err());
+
+        drop(source);
+
+        fs::remove_file(&path)?;
+
+        Ok(())
+    }
+}
@@ -1,5 +1,27 @@
+#[cfg(test)]
+pub use buffer_memory_source::BufferMemorySource;
+pub use capture_memory_source::CaptureMemorySource;
+#[cfg(windows)]
+pub use live_memory_source::LiveMemorySource;
+pub use memory_source::{MemorySource, ModuleEntry};
+pub use minidump_memory_source::MinidumpMemorySource;
 pub use module::Module;
+pub use pe_memory_source::PeMemorySource;
 pub use process::Process;
+pub use recording_memory_source::RecordingMemorySource;
+pub use replay_memory_source::ReplayMemorySource;
+pub use snapshot_memory_source::SnapshotMemorySource;
 
+pub mod buffer_memory_source;
+pub mod capture_memory_source;
+#[cfg(windows)]
+pub mod live_memory_source;
+pub mod memory_source;
+pub mod minidump_memory_source;
 pub mod module;
+pub mod pe_memory_source;
+pub mod pe_view;
 pub mod process;
+pub mod recording_memory_source;
+pub mod replay_memory_source;
+pub mod snapshot_memory_source;
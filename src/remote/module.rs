@@ -1,14 +1,11 @@
-use std::ffi::CStr;
-use std::mem;
-use std::slice;
-
-use windows::Win32::System::Diagnostics::Debug::*;
-use windows::Win32::System::SystemServices::*;
-
 use crate::error::{Error, Result};
 
+use super::pe_view::{parse_exports, PeLayout, PeView, IMAGE_DIRECTORY_ENTRY_EXPORT};
 use super::Process;
 
+/// Largest header span read from a module, far beyond what any real image uses.
+const MAX_HEADERS_SIZE: usize = 0x100000;
+
 #[derive(Debug)]
 pub struct Export {
     pub name: String,
@@ -23,49 +20,39 @@ pub struct Section {
     pub size: usize,
 }
 
-pub struct Module<'a> {
+pub struct Module {
     base: usize,
-    nt_headers: &'a IMAGE_NT_HEADERS64,
     size: u32,
     exports: Vec<Export>,
     sections: Vec<Section>,
 }
 
-impl<'a> Module<'a> {
-    pub fn new(process: &'a Process, base: usize) -> Result<Self> {
-        let mut headers: [u8; 0x1000] = [0; 0x1000];
+impl Module {
+    pub fn new(process: &Process, base: usize) -> Result<Self> {
+        let headers = Self::read_headers(process, base)?;
 
-        process.read_memory_raw(base, headers.as_mut_ptr() as *mut _, headers.len())?;
+        let view = PeView::parse(&headers, PeLayout::Image)?;
 
-        if headers.len() < mem::size_of::<IMAGE_DOS_HEADER>() {
-            return Err(Error::BufferSizeMismatch(
-                mem::size_of::<IMAGE_DOS_HEADER>(),
-                headers.len(),
-            ));
-        }
-
-        let dos_header = unsafe { &*(headers.as_ptr() as *const IMAGE_DOS_HEADER) };
+        let size = view.size_of_image();
 
-        if dos_header.e_magic != IMAGE_DOS_SIGNATURE {
-            return Err(Error::InvalidMagic(dos_header.e_magic as u32));
-        }
+        let exports = Self::read_exports(process, base, &view)?;
 
-        let nt_headers = unsafe {
-            &*(headers.as_ptr().offset(dos_header.e_lfanew as isize) as *const IMAGE_NT_HEADERS64)
-        };
-
-        if nt_headers.Signature != IMAGE_NT_SIGNATURE {
-            return Err(Error::InvalidMagic(nt_headers.Signature));
-        }
-
-        let size = nt_headers.OptionalHeader.SizeOfImage;
+        let sections = view
+            .sections()
+            .map(|section| {
+                let start_va = base + section.virtual_address as usize;
 
-        let exports = unsafe { Self::parse_exports(process, base, size, nt_headers)? };
-        let sections = unsafe { Self::parse_sections(base, nt_headers) };
+                Section {
+                    name: section.name().into_owned(),
+                    start_va,
+                    end_va: start_va + section.virtual_size as usize,
+                    size: section.raw_size as usize,
+                }
+            })
+            .collect();
 
         Ok(Self {
             base,
-            nt_headers,
             size,
             exports,
             sections,
@@ -102,115 +89,58 @@ impl<'a> Module<'a> {
         self.size
     }
 
-    unsafe fn parse_exports(
-        process: &Process,
-        address: usize,
-        size: u32,
-        nt_headers: &IMAGE_NT_HEADERS64,
-    ) -> Result<Vec<Export>> {
-        let export_data_directory =
-            nt_headers.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT.0 as usize];
-
-        let export_directory_start = address + export_data_directory.VirtualAddress as usize;
-        let export_directory_end = export_directory_start + export_data_directory.Size as usize;
-
-        let mut buffer: Vec<u8> = vec![0; export_data_directory.Size as usize];
-
-        process.read_memory_raw(
-            export_directory_start,
-            buffer.as_mut_ptr() as *mut _,
-            buffer.len(),
-        )?;
-
-        if buffer.len() < mem::size_of::<IMAGE_EXPORT_DIRECTORY>() {
-            return Err(Error::BufferSizeMismatch(
-                mem::size_of::<IMAGE_EXPORT_DIRECTORY>(),
-                buffer.len(),
-            ));
-        }
-
-        let export_directory = &*(buffer.as_ptr() as *const IMAGE_EXPORT_DIRECTORY);
+    /// Reads the first page of the image and grows the read until it covers the section table.
+    fn read_headers(process: &Process, base: usize) -> Result<Vec<u8>> {
+        let mut headers: Vec<u8> = vec![0; 0x1000];
 
-        let delta =
-            export_directory as *const _ as usize - export_data_directory.VirtualAddress as usize;
-
-        let name_table = (delta + export_directory.AddressOfNames as usize) as *const u32;
-        let ordinal_table = (delta + export_directory.AddressOfNameOrdinals as usize) as *const u16;
-        let function_table = (delta + export_directory.AddressOfFunctions as usize) as *const u32;
-
-        let mut exports: Vec<Export> = Vec::with_capacity(export_directory.NumberOfNames as usize);
-
-        for i in 0..export_directory.NumberOfNames {
-            let target = ordinal_table as usize + i as usize * mem::size_of::<u16>();
-
-            if target > address + size as usize || target < ordinal_table as usize {
-                continue;
-            }
-
-            let function_ordinal = *ordinal_table.offset(i as isize);
-
-            if function_ordinal as usize > export_directory.NumberOfFunctions as usize {
-                continue;
-            }
+        process.read_memory_raw(base, headers.as_mut_ptr() as *mut _, headers.len())?;
 
-            let function_va = address + *function_table.offset(function_ordinal as isize) as usize;
+        loop {
+            let size = match PeView::required_len(&headers) {
+                Ok(size) => size,
+                Err(Error::BufferSizeMismatch(size, _)) => size,
+                Err(e) => return Err(e),
+            };
 
-            // Skip forwarded exports.
-            if function_va >= export_directory_start && function_va <= export_directory_end {
-                continue;
+            if size <= headers.len() {
+                return Ok(headers);
             }
 
-            let name_ptr = delta.wrapping_add(*name_table.offset(i as isize) as usize) as *const i8;
-
-            if name_ptr.is_null() {
-                continue;
+            if size > MAX_HEADERS_SIZE {
+                return Err(Error::BufferSizeMismatch(MAX_HEADERS_SIZE, size));
             }
 
-            let name = CStr::from_ptr(name_ptr).to_string_lossy().into_owned();
+            headers.resize(size, 0);
 
-            exports.push(Export {
-                name,
-                va: function_va,
-            });
+            process.read_memory_raw(base, headers.as_mut_ptr() as *mut _, headers.len())?;
         }
-
-        Ok(exports)
     }
 
-    unsafe fn parse_sections(address: usize, nt_headers: &IMAGE_NT_HEADERS64) -> Vec<Section> {
-        let optional_header_ptr = &nt_headers.OptionalHeader as *const _ as *const u8;
-
-        let section_header_ptr = optional_header_ptr
-            .offset(nt_headers.FileHeader.SizeOfOptionalHeader as isize)
-            as *const IMAGE_SECTION_HEADER;
+    fn read_exports(process: &Process, base: usize, view: &PeView) -> Result<Vec<Export>> {
+        let directory = view.data_directory(IMAGE_DIRECTORY_ENTRY_EXPORT);
 
-        let sections_raw = slice::from_raw_parts(
-            section_header_ptr,
-            nt_headers.FileHeader.NumberOfSections as usize,
-        );
-
-        sections_raw
-            .iter()
-            .map(|section| {
-                let name = CStr::from_ptr(section.Name.as_ptr() as *const _)
-                    .to_string_lossy()
-                    .into_owned();
+        if directory.size == 0 {
+            return Ok(Vec::new());
+        }
 
-                let start_rva = section.VirtualAddress as usize;
-                let end_rva = start_rva + section.Misc.VirtualSize as usize;
+        if directory.rva as u64 + directory.size as u64 > view.size_of_image() as u64 {
+            return Err(Error::InvalidAddress(base + directory.rva as usize));
+        }
 
-                let start_va = address + start_rva;
-                let end_va = address + end_rva;
+        let mut buffer: Vec<u8> = vec![0; directory.size as usize];
 
-                let size = section.SizeOfRawData as usize;
+        process.read_memory_raw(
+            base + directory.rva as usize,
+            buffer.as_mut_ptr() as *mut _,
+            buffer.len(),
+        )?;
 
-                Section {
-                    name,
-                    start_va,
-                    end_va,
-                    size,
-                }
+        Ok(parse_exports(&buffer, directory.rva)?
+            .into_iter()
+            .map(|(name, rva)| Export {
+                name,
+                va: base + rva as usize,
             })
-            .collect()
+            .collect())
     }
 }
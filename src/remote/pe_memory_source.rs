@@ -0,0 +1,337 @@
+use std::fs::{self, File};
+use std::mem;
+use std::path::{Path, PathBuf};
+
+use memmap2::Mmap;
+
+use crate::error::{Error, Result};
+use crate::mem::{MemoryRegion, Protection};
+
+use super::pe_view::{
+    PeLayout, PeView, IMAGE_DIRECTORY_ENTRY_BASERELOC, IMAGE_SCN_MEM_EXECUTE, IMAGE_SCN_MEM_READ,
+    IMAGE_SCN_MEM_WRITE,
+};
+use super::{MemorySource, ModuleEntry};
+
+const IMAGE_REL_BASED_DIR64: u16 = 10;
+
+struct Mapping {
+    rva: usize,
+    size: usize,
+    file_offset: usize,
+}
+
+struct PeImage {
+    name: String,
+    base: usize,
+    size: usize,
+    preferred_base: usize,
+    data: Mmap,
+    mappings: Vec<Mapping>,
+    regions: Vec<MemoryRegion>,
+    relocations: Vec<u32>,
+}
+
+/// Serves PE files from disk as if they had been loaded by the Windows loader.
+///
+/// Sections are never copied into an image-sized buffer; reads are translated from RVAs to file
+/// offsets on demand, and base relocations are applied to the returned bytes only.
+pub struct PeMemorySource {
+    images: Vec<PeImage>,
+}
+
+impl PeMemorySource {
+    pub fn new(directories: &[PathBuf]) -> Result<Self> {
+        let mut images: Vec<PeImage> = Vec::new();
+
+        for directory in directories {
+            let mut paths: Vec<PathBuf> = fs::read_dir(directory)?
+                .filter_map(|entry| entry.ok().map(|entry| entry.path()))
+                .filter(|path| {
+                    path.extension()
+                        .map_or(false, |extension| extension.eq_ignore_ascii_case("dll"))
+                })
+                .collect();
+
+            paths.sort();
+
+            for path in paths {
+                match PeImage::map(&path) {
+                    Ok(image) if !images.iter().any(|other| other.name == image.name) => {
+                        images.push(image)
+                    }
+                    Ok(_) => {}
+                    Err(e) => log::warn!("Skipping {}: {}", path.display(), e),
+                }
+            }
+        }
+
+        if images.is_empty() {
+            return Err(Error::ModuleNotFound);
+        }
+
+        Self::assign_bases(&mut images);
+
+        images.sort_by_key(|image| image.base);
+
+        Ok(Self { images })
+    }
+
+    /// Places every image at its preferred base if that range is free, and otherwise directly
+    /// after the highest image placed so far.
+    fn assign_bases(images: &mut [PeImage]) {
+        let mut placed: Vec<(usize, usize)> = Vec::with_capacity(images.len());
+
+        for image in images.iter_mut() {
+            let overlaps = |start: usize| {
+                placed
+                    .iter()
+                    .any(|&(base, end)| start < end && base < start + image.size)
+            };
+
+            let base = if image.preferred_base != 0 && !overlaps(image.preferred_base) {
+                image.preferred_base
+            } else {
+                let highest = placed.iter().map(|&(_, end)| end).max().unwrap_or(0x10000);
+
+                (highest + 0xFFFF) & !0xFFFF
+            };
+
+            image.base = base;
+
+            placed.push((base, base + image.size));
+        }
+    }
+
+    fn image(&self, address: usize, size: usize) -> Result<&PeImage> {
+        let index = self.images.partition_point(|image| image.base <= address);
+
+        index
+            .checked_sub(1)
+            .map(|index| &self.images[index])
+            .filter(|image| address + size <= image.base + image.size)
+            .ok_or(Error::InvalidAddress(address))
+    }
+}
+
+impl MemorySource for PeMemorySource {
+    fn read_memory(&self, address: usize, buffer: &mut [u8]) -> Result<()> {
+        let image = self.image(address, buffer.len())?;
+
+        image.read(address - image.base, buffer);
+
+        Ok(())
+    }
+
+    fn modules(&self) -> Result<Vec<ModuleEntry>> {
+        Ok(self
+            .images
+            .iter()
+            .map(|image| ModuleEntry {
+                name: image.name.clone(),
+                base: image.base,
+                size: image.size,
+            })
+            .collect())
+    }
+
+    fn regions(&self) -> Result<Vec<MemoryRegion>> {
+        Ok(self
+            .images
+            .iter()
+            .flat_map(|image| {
+                image.regions.iter().map(|region| MemoryRegion {
+                    start: image.base + region.start,
+                    end: image.base + region.end,
+                    protection: region.protection,
+                })
+            })
+            .collect())
+    }
+}
+
+impl PeImage {
+    fn map(path: &Path) -> Result<Self> {
+        let file = File::open(path)?;
+
+        let data = unsafe { Mmap::map(&file) }?;
+
+        let view = PeView::parse(&data, PeLayout::File)?;
+
+        let mut mappings = vec![Mapping {
+            rva: 0,
+            size: (view.size_of_headers() as usize).min(data.len()),
+            file_offset: 0,
+        }];
+
+        let section_alignment = (view.section_alignment() as usize).max(1);
+
+        // Region offsets are RVAs until the image has been assigned a base.
+        let mut regions = vec![MemoryRegion {
+            start: 0,
+            end: align_up(view.size_of_headers() as usize, section_alignment),
+            protection: Protection::READ,
+        }];
+
+        for section in view.sections() {
+            let virtual_size = section.virtual_size as usize;
+
+            // Only the file-backed part is mapped; the rest of the section reads as zeroes.
+            let size = (section.raw_size as usize)
+                .min(virtual_size)
+                .min(data.len().saturating_sub(section.raw_offset as usize));
+
+            mappings.push(Mapping {
+                rva: section.virtual_address as usize,
+                size,
+                file_offset: section.raw_offset as usize,
+            });
+
+            let mut protection = Protection::NONE;
+
+            if section.characteristics & IMAGE_SCN_MEM_READ != 0 {
+                protection = protection | Protection::READ;
+            }
+
+            if section.characteristics & IMAGE_SCN_MEM_WRITE != 0 {
+                protection = protection | Protection::WRITE;
+            }
+
+            if section.characteristics & IMAGE_SCN_MEM_EXECUTE != 0 {
+                protection = protection | Protection::EXECUTE;
+            }
+
+            let start = section.virtual_address as usize;
+            let end = start + align_up(virtual_size.max(1), section_alignment);
+
+            regions.push(MemoryRegion {
+                start,
+                end: end.min(view.size_of_image() as usize),
+                protection,
+            });
+        }
+
+        let name = path
+            .file_name()
+            .map(|name| name.to_string_lossy().into_owned())
+            .unwrap_or_default();
+
+        let size = view.size_of_image() as usize;
+        let preferred_base = view.image_base() as usize;
+
+        let relocation_directory = view.data_directory(IMAGE_DIRECTORY_ENTRY_BASERELOC);
+
+        let mut image = Self {
+            name,
+            base: 0,
+            size,
+            preferred_base,
+            data,
+            mappings,
+            regions,
+            relocations: Vec::new(),
+        };
+
+        image.relocations = image.parse_relocations(
+            relocation_directory.rva as usize,
+            (relocation_directory.size as usize).min(image.size),
+        );
+
+        Ok(image)
+    }
+
+    fn parse_relocations(&self, rva: usize, size: usize) -> Vec<u32> {
+        let mut directory = vec![0; size];
+
+        self.read_unrelocated(rva, &mut directory);
+
+        let mut relocations = Vec::new();
+
+        let mut offset = 0;
+
+        while offset + 8 <= directory.len() {
+            let page_rva = u32::from_le_bytes(directory[offset..offset + 4].try_into().unwrap());
+            let block_size =
+                u32::from_le_bytes(directory[offset + 4..offset + 8].try_into().unwrap()) as usize;
+
+            if block_size < 8 {
+                break;
+            }
+
+            let block_end = (offset + block_size).min(directory.len());
+
+            for entry in directory[offset + 8..block_end].chunks_exact(2) {
+                let entry = u16::from_le_bytes([entry[0], entry[1]]);
+
+                if entry >> 12 == IMAGE_REL_BASED_DIR64 {
+                    relocations.push(page_rva + (entry & 0xFFF) as u32);
+                }
+            }
+
+            offset += block_size;
+        }
+
+        relocations.sort_unstable();
+
+        relocations
+    }
+
+    fn read(&self, rva: usize, buffer: &mut [u8]) {
+        self.read_unrelocated(rva, buffer);
+
+        let delta = self.base.wrapping_sub(self.preferred_base) as u64;
+
+        if delta == 0 {
+            return;
+        }
+
+        let end = rva + buffer.len();
+
+        // A fixup that starts up to 7 bytes before the read still overlaps it.
+        let first = self
+            .relocations
+            .partition_point(|&site| (site as usize) + mem::size_of::<u64>() <= rva);
+
+        for &site in self.relocations[first..]
+            .iter()
+            .take_while(|&&site| (site as usize) < end)
+        {
+            let site = site as usize;
+
+            let mut value = [0; 8];
+
+            self.read_unrelocated(site, &mut value);
+
+            let value = u64::from_le_bytes(value).wrapping_add(delta).to_le_bytes();
+
+            let start = site.max(rva);
+            let stop = (site + value.len()).min(end);
+
+            buffer[start - rva..stop - rva].copy_from_slice(&value[start - site..stop - site]);
+        }
+    }
+
+    fn read_unrelocated(&self, rva: usize, buffer: &mut [u8]) {
+        buffer.fill(0);
+
+        let end = rva + buffer.len();
+
+        for mapping in &self.mappings {
+            let start = rva.max(mapping.rva);
+            let stop = end.min(mapping.rva + mapping.size);
+
+            if start >= stop {
+                continue;
+            }
+
+            let file_offset = mapping.file_offset + (start - mapping.rva);
+
+            buffer[start - rva..stop - rva]
+                .copy_from_slice(&self.data[file_offset..file_offset + (stop - start)]);
+        }
+    }
+}
+
+fn align_up(value: usize, alignment: usize) -> usize {
+    (value + alignment - 1) / alignment * alignment
+}
@@ -0,0 +1,505 @@
+use std::borrow::Cow;
+
+use crate::error::{Error, Result};
+
+pub const IMAGE_DIRECTORY_ENTRY_EXPORT: usize = 0;
+pub const IMAGE_DIRECTORY_ENTRY_BASERELOC: usize = 5;
+
+pub const IMAGE_SCN_MEM_EXECUTE: u32 = 0x20000000;
+pub const IMAGE_SCN_MEM_READ: u32 = 0x40000000;
+pub const IMAGE_SCN_MEM_WRITE: u32 = 0x80000000;
+
+const IMAGE_DOS_SIGNATURE: u16 = 0x5A4D;
+const IMAGE_NT_SIGNATURE: u32 = 0x4550;
+const IMAGE_NT_OPTIONAL_HDR64_MAGIC: u16 = 0x20B;
+
+const E_LFANEW_OFFSET: usize = 0x3C;
+const FILE_HEADER_SIZE: usize = 0x14;
+const DATA_DIRECTORIES_OFFSET: usize = 0x70;
+const DATA_DIRECTORY_SIZE: usize = 0x8;
+const MAX_DATA_DIRECTORIES: usize = 16;
+const SECTION_HEADER_SIZE: usize = 0x28;
+const EXPORT_DIRECTORY_SIZE: usize = 0x28;
+
+/// How the bytes handed to `PeView` are laid out.
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub enum PeLayout {
+    /// Mapped by the loader, RVAs are offsets into the bytes.
+    Image,
+    /// Stored on disk, RVAs are translated through the section table.
+    File,
+}
+
+#[derive(Clone, Copy, Debug, Default, PartialEq)]
+pub struct DataDirectory {
+    pub rva: u32,
+    pub size: u32,
+}
+
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub struct SectionHeader<'a> {
+    pub raw_name: &'a [u8],
+    pub virtual_size: u32,
+    pub virtual_address: u32,
+    pub raw_size: u32,
+    pub raw_offset: u32,
+    pub characteristics: u32,
+}
+
+impl<'a> SectionHeader<'a> {
+    pub fn name(&self) -> Cow<'a, str> {
+        let len = self
+            .raw_name
+            .iter()
+            .position(|&byte| byte == 0)
+            .unwrap_or(self.raw_name.len());
+
+        String::from_utf8_lossy(&self.raw_name[..len])
+    }
+}
+
+/// Zero-copy view over the headers of a PE32+ image.
+///
+/// Every offset and size taken from the image is checked against the underlying slice, so
+/// malformed or truncated images produce an error instead of an out-of-bounds read. The same view
+/// works over bytes read from a process, a snapshot or a memory-mapped file.
+#[derive(Clone, Copy, Debug)]
+pub struct PeView<'a> {
+    data: &'a [u8],
+    layout: PeLayout,
+    image_base: u64,
+    section_alignment: u32,
+    size_of_image: u32,
+    size_of_headers: u32,
+    data_directories: &'a [u8],
+    section_headers: &'a [u8],
+}
+
+impl<'a> PeView<'a> {
+    pub fn parse(data: &'a [u8], layout: PeLayout) -> Result<Self> {
+        let dos_magic = read_u16(data, 0)?;
+
+        if dos_magic != IMAGE_DOS_SIGNATURE {
+            return Err(Error::InvalidMagic(dos_magic as u32));
+        }
+
+        let nt_headers = read_u32(data, E_LFANEW_OFFSET)? as usize;
+
+        let signature = read_u32(data, nt_headers)?;
+
+        if signature != IMAGE_NT_SIGNATURE {
+            return Err(Error::InvalidMagic(signature));
+        }
+
+        let file_header = nt_headers + 4;
+
+        let section_count = read_u16(data, file_header + 0x2)? as usize;
+        let optional_header_size = read_u16(data, file_header + 0x10)? as usize;
+
+        let optional_header = file_header + FILE_HEADER_SIZE;
+
+        let optional_magic = read_u16(data, optional_header)?;
+
+        if optional_magic != IMAGE_NT_OPTIONAL_HDR64_MAGIC {
+            return Err(Error::InvalidMagic(optional_magic as u32));
+        }
+
+        if optional_header_size < DATA_DIRECTORIES_OFFSET {
+            return Err(Error::BufferSizeMismatch(
+                DATA_DIRECTORIES_OFFSET,
+                optional_header_size,
+            ));
+        }
+
+        // Only the directories that fit in both the declared count and the optional header exist.
+        let data_directory_count = (read_u32(data, optional_header + 0x6C)? as usize)
+            .min((optional_header_size - DATA_DIRECTORIES_OFFSET) / DATA_DIRECTORY_SIZE)
+            .min(MAX_DATA_DIRECTORIES);
+
+        Ok(Self {
+            data,
+            layout,
+            image_base: read_u64(data, optional_header + 0x18)?,
+            section_alignment: read_u32(data, optional_header + 0x20)?,
+            size_of_image: read_u32(data, optional_header + 0x38)?,
+            size_of_headers: read_u32(data, optional_header + 0x3C)?,
+            data_directories: slice(
+                data,
+                optional_header + DATA_DIRECTORIES_OFFSET,
+                data_directory_count * DATA_DIRECTORY_SIZE,
+            )?,
+            section_headers: slice(
+                data,
+                optional_header + optional_header_size,
+                section_count * SECTION_HEADER_SIZE,
+            )?,
+        })
+    }
+
+    /// Returns how many bytes from the start of the image `parse` needs, which can be more than
+    /// a page for images with many sections.
+    ///
+    /// Fails with `Error::BufferSizeMismatch` if `data` doesn't even hold the fields that
+    /// describe the header span, the expected size is then a better guess to retry with.
+    pub fn required_len(data: &[u8]) -> Result<usize> {
+        let nt_headers = read_u32(data, E_LFANEW_OFFSET)? as usize;
+
+        let file_header = nt_headers + 4;
+
+        let section_count = read_u16(data, file_header + 0x2)? as usize;
+        let optional_header_size = read_u16(data, file_header + 0x10)? as usize;
+
+        Ok(file_header
+            + FILE_HEADER_SIZE
+            + optional_header_size
+            + section_count * SECTION_HEADER_SIZE)
+    }
+
+    #[inline]
+    pub fn image_base(&self) -> u64 {
+        self.image_base
+    }
+
+    #[inline]
+    pub fn section_alignment(&self) -> u32 {
+        self.section_alignment
+    }
+
+    #[inline]
+    pub fn size_of_image(&self) -> u32 {
+        self.size_of_image
+    }
+
+    #[inline]
+    pub fn size_of_headers(&self) -> u32 {
+        self.size_of_headers
+    }
+
+    /// Returns the data directory at `index`, or an empty one if the image doesn't have it.
+    pub fn data_directory(&self, index: usize) -> DataDirectory {
+        let offset = index * DATA_DIRECTORY_SIZE;
+
+        match (
+            read_u32(self.data_directories, offset),
+            read_u32(self.data_directories, offset + 4),
+        ) {
+            (Ok(rva), Ok(size)) => DataDirectory { rva, size },
+            _ => DataDirectory::default(),
+        }
+    }
+
+    pub fn sections(&self) -> impl Iterator<Item = SectionHeader<'a>> + 'a {
+        self.section_headers
+            .chunks_exact(SECTION_HEADER_SIZE)
+            .map(|header| SectionHeader {
+                raw_name: &header[..8],
+                virtual_size: read_u32(header, 0x8).unwrap(),
+                virtual_address: read_u32(header, 0xC).unwrap(),
+                raw_size: read_u32(header, 0x10).unwrap(),
+                raw_offset: read_u32(header, 0x14).unwrap(),
+                characteristics: read_u32(header, 0x24).unwrap(),
+            })
+    }
+
+    /// Returns `len` bytes starting at `rva`. In the file layout they have to lie within the
+    /// headers or the file-backed part of a single section.
+    pub fn bytes(&self, rva: u32, len: usize) -> Result<&'a [u8]> {
+        let offset = match self.layout {
+            PeLayout::Image => Some(rva as usize),
+            PeLayout::File => self.rva_to_offset(rva, len),
+        };
+
+        offset
+            .and_then(|offset| slice(self.data, offset, len).ok())
+            .ok_or(Error::InvalidAddress(rva as usize))
+    }
+
+    /// Returns the named exports as name and RVA pairs, skipping forwarded ones.
+    pub fn exports(&self) -> Result<Vec<(String, u32)>> {
+        let directory = self.data_directory(IMAGE_DIRECTORY_ENTRY_EXPORT);
+
+        if directory.size == 0 {
+            return Ok(Vec::new());
+        }
+
+        parse_exports(
+            self.bytes(directory.rva, directory.size as usize)?,
+            directory.rva,
+        )
+    }
+
+    fn rva_to_offset(&self, rva: u32, len: usize) -> Option<usize> {
+        let end = (rva as usize).checked_add(len)?;
+
+        if end <= self.size_of_headers as usize {
+            return Some(rva as usize);
+        }
+
+        self.sections()
+            .find(|section| {
+                let start = section.virtual_address as usize;
+
+                rva as usize >= start
+                    && end <= start + (section.raw_size.min(section.virtual_size)) as usize
+            })
+            .map(|section| section.raw_offset as usize + (rva - section.virtual_address) as usize)
+    }
+}
+
+/// Parses an export directory from `directory`, the bytes of its data directory that start at
+/// `directory_rva`.
+///
+/// The name, ordinal and function tables and the names themselves have to lie within
+/// `directory`, entries pointing anywhere else are skipped.
+pub fn parse_exports(directory: &[u8], directory_rva: u32) -> Result<Vec<(String, u32)>> {
+    if directory.len() < EXPORT_DIRECTORY_SIZE {
+        return Err(Error::BufferSizeMismatch(
+            EXPORT_DIRECTORY_SIZE,
+            directory.len(),
+        ));
+    }
+
+    let function_count = read_u32(directory, 0x14)? as usize;
+    let name_count = read_u32(directory, 0x18)? as usize;
+
+    let table = |rva: u32, entry_size: usize, count: usize| {
+        rva.checked_sub(directory_rva)
+            .and_then(|offset| slice(directory, offset as usize, count * entry_size).ok())
+            .unwrap_or_default()
+    };
+
+    let functions = table(read_u32(directory, 0x1C)?, 4, function_count);
+    let names = table(read_u32(directory, 0x20)?, 4, name_count);
+    let ordinals = table(read_u32(directory, 0x24)?, 2, name_count);
+
+    let directory_end = directory_rva as u64 + directory.len() as u64;
+
+    let mut exports = Vec::with_capacity(names.len() / 4);
+
+    for (name_rva, ordinal) in names.chunks_exact(4).zip(ordinals.chunks_exact(2)) {
+        let ordinal = u16::from_le_bytes([ordinal[0], ordinal[1]]) as usize;
+
+        let Ok(function_rva) = read_u32(functions, ordinal * 4) else {
+            continue;
+        };
+
+        // Forwarded exports point at a string inside the directory.
+        if (directory_rva as u64..directory_end).contains(&(function_rva as u64)) {
+            continue;
+        }
+
+        let name_rva = u32::from_le_bytes(name_rva.try_into().unwrap());
+
+        let Some(name) = name_rva
+            .checked_sub(directory_rva)
+            .and_then(|offset| directory.get(offset as usize..))
+            .and_then(|name| {
+                name.iter()
+                    .position(|&byte| byte == 0)
+                    .map(|len| &name[..len])
+            })
+        else {
+            continue;
+        };
+
+        exports.push((String::from_utf8_lossy(name).into_owned(), function_rva));
+    }
+
+    Ok(exports)
+}
+
+fn slice(data: &[u8], offset: usize, len: usize) -> Result<&[u8]> {
+    let end = offset.saturating_add(len);
+
+    data.get(offset..end)
+        .ok_or(Error::BufferSizeMismatch(end, data.len()))
+}
+
+fn read_u16(data: &[u8], offset: usize) -> Result<u16> {
+    Ok(u16::from_le_bytes(
+        slice(data, offset, 2)?.try_into().unwrap(),
+    ))
+}
+
+fn read_u32(data: &[u8], offset: usize) -> Result<u32> {
+    Ok(u32::from_le_bytes(
+        slice(data, offset, 4)?.try_into().unwrap(),
+    ))
+}
+
+fn read_u64(data: &[u8], offset: usize) -> Result<u64> {
+    Ok(u64::from_le_bytes(
+        slice(data, offset, 8)?.try_into().unwrap(),
+    ))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const NT_HEADERS: usize = 0x40;
+    const SECTION_HEADERS: usize = NT_HEADERS + 0x18 + 0xF0;
+    const EXPORT_RVA: usize = 0x2000;
+
+    fn write(data: &mut [u8], offset: usize, bytes: &[u8]) {
+        data[offset..offset + bytes.len()].copy_from_slice(bytes);
+    }
+
+    /// Builds a file-layout image with `section_count` sections, the last one holding an export
+    /// directory with a named export, a forwarded export and a name outside the directory.
+    fn image(section_count: usize) -> Vec<u8> {
+        let headers_size = (SECTION_HEADERS + section_count * SECTION_HEADER_SIZE + 0x1FF) & !0x1FF;
+
+        let mut data = vec![0; headers_size + 0x200];
+
+        let optional_header = NT_HEADERS + 0x18;
+
+        write(&mut data, 0x0, b"MZ");
+        write(&mut data, 0x3C, &(NT_HEADERS as u32).to_le_bytes());
+        write(&mut data, NT_HEADERS, b"PE\0\0");
+        write(
+            &mut data,
+            NT_HEADERS + 0x6,
+            &(section_count as u16).to_le_bytes(),
+        );
+        write(&mut data, NT_HEADERS + 0x14, &0xF0u16.to_le_bytes());
+        write(&mut data, optional_header, &0x20Bu16.to_le_bytes());
+        write(
+            &mut data,
+            optional_header + 0x18,
+            &0x180000000u64.to_le_bytes(),
+        );
+        write(&mut data, optional_header + 0x20, &0x1000u32.to_le_bytes());
+        write(&mut data, optional_header + 0x38, &0x3000u32.to_le_bytes());
+        write(
+            &mut data,
+            optional_header + 0x3C,
+            &(headers_size as u32).to_le_bytes(),
+        );
+        write(&mut data, optional_header + 0x6C, &16u32.to_le_bytes());
+        write(
+            &mut data,
+            optional_header + 0x70,
+            &(EXPORT_RVA as u32).to_le_bytes(),
+        );
+        write(&mut data, optional_header + 0x74, &0x80u32.to_le_bytes());
+
+        for i in 0..section_count {
+            let header = SECTION_HEADERS + i * SECTION_HEADER_SIZE;
+
+            write(&mut data, header, b".data\0\0\0");
+            write(&mut data, header + 0x8, &0x200u32.to_le_bytes());
+            write(&mut data, header + 0xC, &(EXPORT_RVA as u32).to_le_bytes());
+            write(&mut data, header + 0x10, &0x200u32.to_le_bytes());
+            write(
+                &mut data,
+                header + 0x14,
+                &(headers_size as u32).to_le_bytes(),
+            );
+        }
+
+        let directory = headers_size;
+
+        write(&mut data, directory + 0x14, &2u32.to_le_bytes());
+        write(&mut data, directory + 0x18, &3u32.to_le_bytes());
+        write(
+            &mut data,
+            directory + 0x1C,
+            &(EXPORT_RVA as u32 + 0x28).to_le_bytes(),
+        );
+        write(
+            &mut data,
+            directory + 0x20,
+            &(EXPORT_RVA as u32 + 0x30).to_le_bytes(),
+        );
+        write(
+            &mut data,
+            directory + 0x24,
+            &(EXPORT_RVA as u32 + 0x3C).to_le_bytes(),
+        );
+
+        // Functions: one in the code, one forwarded into the directory.
+        write(&mut data, directory + 0x28, &0x1234u32.to_le_bytes());
+        write(
+            &mut data,
+            directory + 0x2C,
+            &(EXPORT_RVA as u32 + 0x70).to_le_bytes(),
+        );
+
+        // Names: a valid one, the forwarded one and one far outside the image.
+        write(
+            &mut data,
+            directory + 0x30,
+            &(EXPORT_RVA as u32 + 0x50).to_le_bytes(),
+        );
+        write(
+            &mut data,
+            directory + 0x34,
+            &(EXPORT_RVA as u32 + 0x60).to_le_bytes(),
+        );
+        write(&mut data, directory + 0x38, &0xFFFFFFF0u32.to_le_bytes());
+
+        write(&mut data, directory + 0x3C, &[0, 0, 1, 0, 0, 0]);
+
+        write(&mut data, directory + 0x50, b"CreateInterface\0");
+        write(&mut data, directory + 0x60, b"Forwarded\0");
+        write(&mut data, directory + 0x70, b"other.Function\0");
+
+        data
+    }
+
+    #[test]
+    fn parse_file_layout() -> Result<()> {
+        let data = image(120);
+
+        // The section table spills past the first page.
+        assert!(PeView::required_len(&data[..0x1000])? > 0x1000);
+        assert!(PeView::parse(&data[..0x1000], PeLayout::File).is_err());
+
+        let view = PeView::parse(&data, PeLayout::File)?;
+
+        assert_eq!(view.image_base(), 0x180000000);
+        assert_eq!(view.sections().count(), 120);
+        assert_eq!(view.sections().next().unwrap().name(), ".data");
+
+        assert_eq!(
+            view.exports()?,
+            vec![("CreateInterface".to_string(), 0x1234)]
+        );
+
+        Ok(())
+    }
+
+    #[test]
+    fn malformed_images_are_rejected() {
+        let data = image(2);
+
+        let check = |data: &[u8]| {
+            for layout in [PeLayout::Image, PeLayout::File] {
+                let _ = PeView::required_len(data);
+
+                if let Ok(view) = PeView::parse(data, layout) {
+                    for section in view.sections() {
+                        let _ = view.bytes(section.virtual_address, section.raw_size as usize);
+                    }
+
+                    let _ = view.exports();
+                }
+            }
+        };
+
+        for len in 0..data.len() {
+            check(&data[..len]);
+        }
+
+        for offset in 0..data.len() {
+            for value in [0x00, 0x7F, 0x80, 0xFF] {
+                let mut data = data.clone();
+
+                data[offset] = value;
+
+                check(&data);
+            }
+        }
+    }
+}
@@ -1,127 +1,102 @@
-use std::ffi::{c_void, CStr};
+use std::ffi::c_void;
 use std::mem;
-use std::ptr;
-
-use windows::Win32::Foundation::*;
-use windows::Win32::System::Diagnostics::Debug::*;
-use windows::Win32::System::Diagnostics::ToolHelp::*;
-use windows::Win32::System::Threading::*;
+use std::slice;
+use std::sync::OnceLock;
 
 use crate::error::{Error, Result};
+use crate::mem::RegionMap;
+
+#[cfg(windows)]
+use super::LiveMemorySource;
+use super::{MemorySource, Module, ModuleEntry};
+
+const PAGE_SIZE: usize = 0x1000;
+
+const STRING_CHUNK_SIZE: usize = 0x80;
 
-use super::Module;
+/// Largest span read at once by `read_strings`.
+const STRING_BATCH_SIZE: usize = 0x10000;
 
-#[derive(Debug)]
 pub struct Process {
-    process_id: u32,
-    process_handle: HANDLE,
+    source: Box<dyn MemorySource>,
+    regions: OnceLock<Option<RegionMap>>,
 }
 
 impl Process {
+    #[cfg(windows)]
     pub fn new(process_name: &str) -> Result<Self> {
-        let process_id = Self::get_process_id_by_name(process_name)?;
-
-        let process_handle = unsafe { OpenProcess(PROCESS_ALL_ACCESS, false, process_id) }?;
-
-        Ok(Self {
-            process_id,
-            process_handle,
-        })
+        Ok(Self::with_source(LiveMemorySource::new(process_name)?))
     }
 
-    pub fn find_pattern(&self, module_name: &str, pattern: &str) -> Result<usize> {
-        let module = self.get_module_by_name(module_name)?;
-
-        let mut module_data: Vec<u8> = vec![0; module.size() as usize];
-
-        self.read_memory_raw(
-            module.base(),
-            module_data.as_mut_ptr() as *mut _,
-            module_data.len(),
-        )?;
-
-        let pattern_bytes = Self::pattern_to_bytes(pattern);
-
-        for i in 0..module.size() as usize - pattern.len() {
-            let mut found = true;
-
-            for j in 0..pattern_bytes.len() {
-                if module_data[i + j] != pattern_bytes[j] as u8 && pattern_bytes[j] != -1 {
-                    found = false;
-
-                    break;
-                }
-            }
-
-            if found {
-                return Ok(module.base() + i);
-            }
+    pub fn with_source<S: MemorySource + 'static>(source: S) -> Self {
+        Self {
+            source: Box::new(source),
+            regions: OnceLock::new(),
         }
-
-        Err(Error::PatternNotFound)
     }
 
-    pub fn get_loaded_modules(&self) -> Result<Vec<String>> {
-        let snapshot = unsafe { CreateToolhelp32Snapshot(TH32CS_SNAPMODULE, self.process_id) }?;
-
-        let mut entry = MODULEENTRY32 {
-            dwSize: mem::size_of::<MODULEENTRY32>() as u32,
-            ..Default::default()
-        };
+    /// Returns the region map of the process, which is queried once on first use.
+    ///
+    /// Sources that cannot enumerate their regions return `None`, and reads are then passed
+    /// through unchecked.
+    pub fn regions(&self) -> Option<&RegionMap> {
+        self.regions
+            .get_or_init(|| self.source.regions().ok().map(RegionMap::new))
+            .as_ref()
+    }
 
-        let mut modules = Vec::new();
+    pub fn modules(&self) -> Result<Vec<ModuleEntry>> {
+        self.source.modules()
+    }
 
-        unsafe {
-            Module32First(snapshot, &mut entry)?;
+    pub fn get_loaded_modules(&self) -> Result<Vec<String>> {
+        Ok(self
+            .source
+            .modules()?
+            .into_iter()
+            .map(|module| module.name)
+            .collect())
+    }
 
-            while Module32Next(snapshot, &mut entry).is_ok() {
-                let name = CStr::from_ptr(&entry.szModule as *const _ as *const _)
-                    .to_string_lossy()
-                    .into_owned();
+    pub fn get_module_by_name(&self, module_name: &str) -> Result<Module> {
+        let entry = self
+            .source
+            .modules()?
+            .into_iter()
+            .find(|module| module.name == module_name)
+            .ok_or(Error::ModuleNotFound)?;
+
+        Module::new(self, entry.base)
+    }
 
-                modules.push(name);
+    pub fn read_memory_raw(&self, address: usize, buffer: *mut c_void, size: usize) -> Result<()> {
+        if let Some(regions) = self.regions() {
+            if !regions.is_readable(address, size) {
+                return Err(Error::InvalidAddress(address));
             }
         }
 
-        Ok(modules)
-    }
+        let buffer = unsafe { slice::from_raw_parts_mut(buffer as *mut u8, size) };
 
-    pub fn get_module_by_name(&self, module_name: &str) -> Result<Module> {
-        let snapshot = unsafe { CreateToolhelp32Snapshot(TH32CS_SNAPMODULE, self.process_id) }?;
+        self.source.read_memory(address, buffer)
+    }
 
-        let mut entry = MODULEENTRY32 {
-            dwSize: mem::size_of::<MODULEENTRY32>() as u32,
-            ..Default::default()
+    /// Reads as much of `buffer` as is readable from `address` onwards and returns the number of
+    /// bytes read.
+    pub fn read_memory_clipped(&self, address: usize, buffer: &mut [u8]) -> usize {
+        let size = match self.regions() {
+            Some(regions) => regions.readable_len(address, buffer.len()),
+            None => buffer.len(),
         };
 
-        unsafe {
-            Module32First(snapshot, &mut entry)?;
-
-            while Module32Next(snapshot, &mut entry).is_ok() {
-                let name = CStr::from_ptr(&entry.szModule as *const _ as *const _)
-                    .to_string_lossy()
-                    .into_owned();
-
-                if name == module_name {
-                    return Module::new(self, entry.modBaseAddr as usize);
-                }
-            }
+        if size == 0 {
+            return 0;
         }
 
-        Err(Error::ModuleNotFound)
-    }
-
-    pub fn read_memory_raw(&self, address: usize, buffer: *mut c_void, size: usize) -> Result<()> {
-        unsafe {
-            ReadProcessMemory(
-                self.process_handle,
-                address as *const _,
-                buffer,
-                size,
-                Some(ptr::null_mut()),
-            )
+        match self.source.read_memory(address, &mut buffer[..size]) {
+            Ok(()) => size,
+            Err(_) => 0,
         }
-        .map_err(Into::into)
     }
 
     pub fn write_memory_raw(
@@ -130,28 +105,17 @@ impl Process {
         buffer: *const c_void,
         size: usize,
     ) -> Result<()> {
-        unsafe {
-            WriteProcessMemory(
-                self.process_handle,
-                address as *const _,
-                buffer,
-                size,
-                Some(ptr::null_mut()),
-            )
-        }
-        .map_err(Into::into)
+        let buffer = unsafe { slice::from_raw_parts(buffer as *const u8, size) };
+
+        self.source.write_memory(address, buffer)
     }
 
     pub fn read_memory<T>(&self, address: usize) -> Result<T> {
-        let mut buffer: T = unsafe { mem::zeroed() };
-
-        self.read_memory_raw(
-            address,
-            &mut buffer as *const _ as *mut _,
-            mem::size_of::<T>(),
-        )?;
+        read_with(address, |address, buffer| self.read_bytes(address, buffer))
+    }
 
-        Ok(buffer)
+    fn read_bytes(&self, address: usize, buffer: &mut [u8]) -> Result<()> {
+        self.read_memory_raw(address, buffer.as_mut_ptr() as *mut _, buffer.len())
     }
 
     pub fn write_memory<T>(&self, address: usize, value: T) -> Result<()> {
@@ -161,25 +125,95 @@ impl Process {
     pub fn read_string(&self, address: usize) -> Result<String> {
         let mut buffer = Vec::new();
 
-        for i in 0.. {
-            match self.read_memory::<u8>(address + i) {
-                Ok(byte) if byte != 0 => buffer.push(byte),
-                _ => break,
+        let mut chunk = [0; STRING_CHUNK_SIZE];
+
+        loop {
+            let current = address + buffer.len();
+
+            // Chunks never cross a page boundary, so an unreadable page only ends the string
+            // where a byte-by-byte read would have.
+            let size = STRING_CHUNK_SIZE.min(PAGE_SIZE - current % PAGE_SIZE);
+
+            let read = self.read_memory_clipped(current, &mut chunk[..size]);
+
+            match chunk[..read].iter().position(|&byte| byte == 0) {
+                Some(len) => {
+                    buffer.extend_from_slice(&chunk[..len]);
+
+                    break;
+                }
+                None => buffer.extend_from_slice(&chunk[..read]),
+            }
+
+            if read < size {
+                break;
             }
         }
 
         Ok(String::from_utf8(buffer)?)
     }
 
+    /// Reads the null-terminated strings at `addresses`.
+    ///
+    /// Strings that lie within a page of each other are fetched with a single read, and only
+    /// strings that run past the end of their batch are read on their own.
+    pub fn read_strings(&self, addresses: &[usize]) -> Vec<Result<String>> {
+        let mut order: Vec<usize> = (0..addresses.len()).collect();
+
+        order.sort_by_key(|&i| addresses[i]);
+
+        let mut results: Vec<Option<Result<String>>> = addresses.iter().map(|_| None).collect();
+
+        let mut buffer = Vec::new();
+
+        let mut first = 0;
+
+        while first < order.len() {
+            let start = addresses[order[first]];
+            let mut end = start + STRING_CHUNK_SIZE;
+
+            let mut last = first + 1;
+
+            while let Some(&next) = order.get(last) {
+                let next_end = addresses[next] + STRING_CHUNK_SIZE;
+
+                if addresses[next] > end + PAGE_SIZE || next_end - start > STRING_BATCH_SIZE {
+                    break;
+                }
+
+                end = end.max(next_end);
+                last += 1;
+            }
+
+            buffer.resize(end - start, 0);
+
+            let read = self.read_memory_clipped(start, &mut buffer);
+
+            for &i in &order[first..last] {
+                let offset = (addresses[i] - start).min(read);
+
+                results[i] = Some(match buffer[offset..read].iter().position(|&b| b == 0) {
+                    Some(len) => String::from_utf8(buffer[offset..offset + len].to_vec())
+                        .map_err(Error::from),
+                    None => self.read_string(addresses[i]),
+                });
+            }
+
+            first = last;
+        }
+
+        results.into_iter().map(Option::unwrap).collect()
+    }
+
     pub fn resolve_jmp(
         &self,
         address: usize,
         offset: Option<usize>,
         length: Option<usize>,
     ) -> Result<usize> {
-        let displacement = self.read_memory::<i32>(address + offset.unwrap_or(0x1))?;
-
-        Ok((address + length.unwrap_or(0x5)) + displacement as usize)
+        resolve_jmp_with(address, offset, length, |address, buffer| {
+            self.read_bytes(address, buffer)
+        })
     }
 
     pub fn resolve_rip(
@@ -188,80 +222,95 @@ impl Process {
         offset: Option<usize>,
         length: Option<usize>,
     ) -> Result<usize> {
-        let displacement = self.read_memory::<i32>(address + offset.unwrap_or(0x3))?;
-
-        Ok((address + length.unwrap_or(0x7)) + displacement as usize)
+        resolve_rip_with(address, offset, length, |address, buffer| {
+            self.read_bytes(address, buffer)
+        })
     }
+}
 
-    fn get_process_id_by_name(process_name: &str) -> Result<u32> {
-        let snapshot = unsafe { CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0) }?;
-
-        let mut entry = PROCESSENTRY32 {
-            dwSize: mem::size_of::<PROCESSENTRY32>() as u32,
-            ..Default::default()
-        };
-
-        unsafe {
-            Process32First(snapshot, &mut entry)?;
+/// Reads a `T` from `address` through `read`, which fills a buffer with the bytes at an address.
+///
+/// Anything that can read memory, such as `Process` or a `Session` with its cached images, shares
+/// these helpers instead of decoding values itself.
+pub fn read_with<T, F>(address: usize, read: F) -> Result<T>
+where
+    F: FnOnce(usize, &mut [u8]) -> Result<()>,
+{
+    let mut value: T = unsafe { mem::zeroed() };
 
-            while Process32Next(snapshot, &mut entry).is_ok() {
-                let name = CStr::from_ptr(&entry.szExeFile as *const _ as *const _)
-                    .to_string_lossy()
-                    .into_owned();
+    let buffer =
+        unsafe { slice::from_raw_parts_mut(&mut value as *mut _ as *mut u8, mem::size_of::<T>()) };
 
-                if name == process_name {
-                    return Ok(entry.th32ProcessID);
-                }
-            }
-        }
+    read(address, buffer)?;
 
-        Err(Error::ProcessNotFound)
-    }
+    Ok(value)
+}
 
-    fn pattern_to_bytes(pattern: &str) -> Vec<i32> {
-        let mut bytes = Vec::new();
+/// Resolves the target of a relative `jmp` or `call` at `address`, reading through `read`.
+pub fn resolve_jmp_with<F>(
+    address: usize,
+    offset: Option<usize>,
+    length: Option<usize>,
+    read: F,
+) -> Result<usize>
+where
+    F: FnOnce(usize, &mut [u8]) -> Result<()>,
+{
+    resolve_relative(address, offset.unwrap_or(0x1), length.unwrap_or(0x5), read)
+}
 
-        let chars: Vec<char> = pattern.chars().collect();
+/// Resolves the target of a RIP-relative instruction at `address`, reading through `read`.
+pub fn resolve_rip_with<F>(
+    address: usize,
+    offset: Option<usize>,
+    length: Option<usize>,
+    read: F,
+) -> Result<usize>
+where
+    F: FnOnce(usize, &mut [u8]) -> Result<()>,
+{
+    resolve_relative(address, offset.unwrap_or(0x3), length.unwrap_or(0x7), read)
+}
 
-        let mut i = 0;
+fn resolve_relative<F>(address: usize, offset: usize, length: usize, read: F) -> Result<usize>
+where
+    F: FnOnce(usize, &mut [u8]) -> Result<()>,
+{
+    let displacement = read_with::<i32, _>(address + offset, read)?;
 
-        while i < chars.len() {
-            if chars[i] == ' ' {
-                i += 1;
+    Ok((address + length).wrapping_add_signed(displacement as isize))
+}
 
-                continue;
-            }
+#[cfg(test)]
+mod tests {
+    use super::*;
 
-            if chars[i] == '?' {
-                bytes.push(-1);
+    use crate::remote::BufferMemorySource;
 
-                i += 1;
+    #[test]
+    fn read_strings() -> Result<()> {
+        let mut data = vec![b'x'; 0x3000];
 
-                continue;
-            }
+        // Two strings in one batch, one a page further on and one that runs past the buffer.
+        data[0x10..0x16].copy_from_slice(b"alpha\0");
+        data[0x40..0x45].copy_from_slice(b"beta\0");
+        data[0x1100..0x1106].copy_from_slice(b"gamma\0");
+        data[0x2FFF] = 0;
 
-            if i + 1 < chars.len() {
-                let value = i32::from_str_radix(&pattern[i..i + 2], 16);
+        let mut source = BufferMemorySource::new();
 
-                match value {
-                    Ok(v) => bytes.push(v),
-                    Err(_) => {}
-                }
+        source.add_buffer(0x10000, data);
 
-                i += 1;
-            }
+        let process = Process::with_source(source);
 
-            i += 1;
-        }
+        let strings: Vec<String> = process
+            .read_strings(&[0x11100, 0x10010, 0x10040, 0x12F00])
+            .into_iter()
+            .collect::<Result<_>>()?;
 
-        bytes
-    }
-}
+        assert_eq!(strings[..3], ["gamma", "alpha", "beta"]);
+        assert_eq!(strings[3].len(), 0xFF);
 
-impl Drop for Process {
-    fn drop(&mut self) {
-        if !self.process_handle.is_invalid() {
-            unsafe { CloseHandle(self.process_handle).unwrap() }
-        }
+        Ok(())
     }
 }
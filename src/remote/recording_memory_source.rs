@@ -0,0 +1,220 @@
+use std::collections::HashMap;
+use std::fs::File;
+use std::io::{self, BufWriter, Seek, Write};
+use std::path::Path;
+use std::sync::Mutex;
+
+use crate::error::Result;
+use crate::mem::MemoryRegion;
+
+use super::{MemorySource, ModuleEntry};
+
+pub const TRACE_MAGIC: &[u8; 8] = b"CS2TRACE";
+pub const TRACE_VERSION: u32 = 1;
+
+/// Size of the footer at the end of a trace: three section offsets, the total read count and the
+/// trailing magic.
+pub const TRACE_FOOTER_SIZE: usize = 8 * 4 + TRACE_MAGIC.len();
+
+pub struct TraceIndexEntry {
+    pub address: u64,
+    pub size: u32,
+    pub ok: bool,
+    pub data_offset: u64,
+}
+
+struct Recorder {
+    writer: BufWriter<File>,
+    position: u64,
+    index: Vec<TraceIndexEntry>,
+    seen: HashMap<(usize, usize), usize>,
+    read_count: u64,
+    read_bytes: u64,
+    modules: Option<Vec<ModuleEntry>>,
+    regions: Option<Vec<MemoryRegion>>,
+    /// The first failed write, after which nothing more is recorded.
+    error: Option<io::Error>,
+}
+
+/// Forwards every call to another source and logs the results to a trace file.
+///
+/// The trace holds the payload of every distinct `(address, size)` read once, followed by the
+/// module list, the region list and an index of all reads. The trailer is written when the
+/// source is dropped.
+pub struct RecordingMemorySource {
+    inner: Box<dyn MemorySource>,
+    recorder: Mutex<Recorder>,
+}
+
+impl RecordingMemorySource {
+    pub fn new(inner: Box<dyn MemorySource>, path: &Path) -> Result<Self> {
+        let mut writer = BufWriter::new(File::create(path)?);
+
+        writer.write_all(TRACE_MAGIC)?;
+        writer.write_all(&TRACE_VERSION.to_le_bytes())?;
+
+        Ok(Self {
+            inner,
+            recorder: Mutex::new(Recorder {
+                writer,
+                position: (TRACE_MAGIC.len() + 4) as u64,
+                index: Vec::new(),
+                seen: HashMap::new(),
+                read_count: 0,
+                read_bytes: 0,
+                modules: None,
+                regions: None,
+                error: None,
+            }),
+        })
+    }
+
+    fn finish(&mut self) -> Result<()> {
+        if let Some(e) = self.recorder.get_mut().unwrap().error.take() {
+            return Err(e.into());
+        }
+
+        if self.recorder.get_mut().unwrap().modules.is_none() {
+            self.modules()?;
+        }
+
+        if self.recorder.get_mut().unwrap().regions.is_none() {
+            let _ = self.regions();
+        }
+
+        let recorder = self.recorder.get_mut().unwrap();
+
+        let writer = &mut recorder.writer;
+
+        let modules_offset = writer.stream_position()?;
+
+        let modules = recorder.modules.as_deref().unwrap_or_default();
+
+        writer.write_all(&(modules.len() as u32).to_le_bytes())?;
+
+        for module in modules {
+            writer.write_all(&(module.name.len() as u16).to_le_bytes())?;
+            writer.write_all(module.name.as_bytes())?;
+            writer.write_all(&(module.base as u64).to_le_bytes())?;
+            writer.write_all(&(module.size as u64).to_le_bytes())?;
+        }
+
+        let regions_offset = writer.stream_position()?;
+
+        match &recorder.regions {
+            Some(regions) => {
+                writer.write_all(&(regions.len() as u32).to_le_bytes())?;
+
+                for region in regions {
+                    writer.write_all(&(region.start as u64).to_le_bytes())?;
+                    writer.write_all(&(region.end as u64).to_le_bytes())?;
+                    writer.write_all(&[region.protection.bits()])?;
+                }
+            }
+            None => writer.write_all(&u32::MAX.to_le_bytes())?,
+        }
+
+        let index_offset = writer.stream_position()?;
+
+        writer.write_all(&(recorder.index.len() as u32).to_le_bytes())?;
+
+        for entry in &recorder.index {
+            writer.write_all(&entry.address.to_le_bytes())?;
+            writer.write_all(&entry.size.to_le_bytes())?;
+            writer.write_all(&[entry.ok as u8])?;
+            writer.write_all(&entry.data_offset.to_le_bytes())?;
+        }
+
+        writer.write_all(&modules_offset.to_le_bytes())?;
+        writer.write_all(&regions_offset.to_le_bytes())?;
+        writer.write_all(&index_offset.to_le_bytes())?;
+        writer.write_all(&recorder.read_count.to_le_bytes())?;
+        writer.write_all(TRACE_MAGIC)?;
+
+        writer.flush()?;
+
+        log::info!(
+            "Recorded {} reads ({} distinct, {} bytes).",
+            recorder.read_count,
+            recorder.index.len(),
+            recorder.read_bytes
+        );
+
+        Ok(())
+    }
+}
+
+impl MemorySource for RecordingMemorySource {
+    fn read_memory(&self, address: usize, buffer: &mut [u8]) -> Result<()> {
+        let result = self.inner.read_memory(address, buffer);
+
+        let mut recorder = self.recorder.lock().unwrap();
+
+        recorder.read_count += 1;
+        recorder.read_bytes += buffer.len() as u64;
+
+        // Repeated reads are served from the first recording of the same range, and nothing is
+        // recorded after a failed write.
+        if recorder.error.is_some() || recorder.seen.contains_key(&(address, buffer.len())) {
+            return result;
+        }
+
+        let data_offset = recorder.position;
+
+        // A failed write breaks the trace, not the read, so it is only reported by `finish`.
+        if result.is_ok() {
+            if let Err(e) = recorder.writer.write_all(buffer) {
+                recorder.error = Some(e);
+
+                return result;
+            }
+
+            recorder.position += buffer.len() as u64;
+        }
+
+        let index = recorder.index.len();
+
+        recorder.seen.insert((address, buffer.len()), index);
+
+        recorder.index.push(TraceIndexEntry {
+            address: address as u64,
+            size: buffer.len() as u32,
+            ok: result.is_ok(),
+            data_offset,
+        });
+
+        result
+    }
+
+    fn modules(&self) -> Result<Vec<ModuleEntry>> {
+        let modules = self.inner.modules()?;
+
+        self.recorder
+            .lock()
+            .unwrap()
+            .modules
+            .get_or_insert_with(|| modules.clone());
+
+        Ok(modules)
+    }
+
+    fn regions(&self) -> Result<Vec<MemoryRegion>> {
+        let regions = self.inner.regions()?;
+
+        self.recorder
+            .lock()
+            .unwrap()
+            .regions
+            .get_or_insert_with(|| regions.clone());
+
+        Ok(regions)
+    }
+}
+
+impl Drop for RecordingMemorySource {
+    fn drop(&mut self) {
+        if let Err(e) = self.finish() {
+            log::error!("Failed to write read trace: {}", e);
+        }
+    }
+}
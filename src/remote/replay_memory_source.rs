@@ -0,0 +1,362 @@
+use std::collections::HashMap;
+use std::fs::File;
+use std::path::Path;
+use std::sync::atomic::{AtomicU64, Ordering};
+
+use memmap2::Mmap;
+
+use crate::error::{Error, Result};
+use crate::mem::{ByteReader, MemoryRegion, Protection};
+
+use super::recording_memory_source::{TRACE_FOOTER_SIZE, TRACE_MAGIC, TRACE_VERSION};
+use super::{MemorySource, ModuleEntry};
+
+struct Piece {
+    start: usize,
+    end: usize,
+    data_offset: usize,
+}
+
+/// Serves reads from a trace written by `RecordingMemorySource`.
+///
+/// Reads that were recorded verbatim are answered through a hash index. Any other read is served
+/// from the recorded data if it is fully covered by earlier reads, so changes that merge or split
+/// reads can still be replayed.
+pub struct ReplayMemorySource {
+    data: Mmap,
+    index: HashMap<(usize, usize), Option<usize>>,
+    pieces: Vec<Piece>,
+    modules: Vec<ModuleEntry>,
+    regions: Option<Vec<MemoryRegion>>,
+    recorded_reads: u64,
+    exact_hits: AtomicU64,
+    covered_hits: AtomicU64,
+    misses: AtomicU64,
+}
+
+impl ReplayMemorySource {
+    pub fn new(path: &Path) -> Result<Self> {
+        let file = File::open(path)?;
+
+        let data = unsafe { Mmap::map(&file) }?;
+
+        let mut reader = ByteReader::new(&data);
+
+        if reader.bytes(TRACE_MAGIC.len())? != TRACE_MAGIC {
+            return Err(Error::InvalidMagic(0));
+        }
+
+        let version = reader.u32()?;
+
+        if version != TRACE_VERSION {
+            return Err(Error::InvalidMagic(version));
+        }
+
+        reader.position = data
+            .len()
+            .checked_sub(TRACE_FOOTER_SIZE)
+            .ok_or(Error::BufferSizeMismatch(TRACE_FOOTER_SIZE, data.len()))?;
+
+        let modules_offset = reader.u64()? as usize;
+        let regions_offset = reader.u64()? as usize;
+        let index_offset = reader.u64()? as usize;
+        let recorded_reads = reader.u64()?;
+
+        if reader.bytes(TRACE_MAGIC.len())? != TRACE_MAGIC {
+            return Err(Error::InvalidMagic(0));
+        }
+
+        reader.position = modules_offset;
+
+        let modules = (0..reader.u32()?)
+            .map(|_| {
+                let name_len = reader.u16()? as usize;
+                let name = String::from_utf8(reader.bytes(name_len)?.to_vec())?;
+
+                Ok(ModuleEntry {
+                    name,
+                    base: reader.u64()? as usize,
+                    size: reader.u64()? as usize,
+                })
+            })
+            .collect::<Result<Vec<_>>>()?;
+
+        reader.position = regions_offset;
+
+        let regions = match reader.u32()? {
+            u32::MAX => None,
+            count => Some(
+                (0..count)
+                    .map(|_| {
+                        Ok(MemoryRegion {
+                            start: reader.u64()? as usize,
+                            end: reader.u64()? as usize,
+                            protection: Protection::from_bits(reader.bytes(1)?[0]),
+                        })
+                    })
+                    .collect::<Result<Vec<_>>>()?,
+            ),
+        };
+
+        reader.position = index_offset;
+
+        let count = reader.u32()? as usize;
+
+        let mut index = HashMap::with_capacity(count);
+        let mut recorded: Vec<(usize, usize, usize)> = Vec::with_capacity(count);
+
+        for _ in 0..count {
+            let address = reader.u64()? as usize;
+            let size = reader.u32()? as usize;
+            let ok = reader.bytes(1)?[0] != 0;
+            let data_offset = reader.u64()? as usize;
+
+            index.insert((address, size), ok.then_some(data_offset));
+
+            if !ok {
+                continue;
+            }
+
+            if data_offset
+                .checked_add(size)
+                .map_or(true, |data_end| data_end > index_offset)
+            {
+                return Err(Error::BufferSizeMismatch(
+                    data_offset.saturating_add(size),
+                    index_offset,
+                ));
+            }
+
+            let end = address
+                .checked_add(size)
+                .ok_or(Error::InvalidAddress(address))?;
+
+            recorded.push((address, end, data_offset));
+        }
+
+        Ok(Self {
+            pieces: Self::build_pieces(recorded),
+            data,
+            index,
+            modules,
+            regions,
+            recorded_reads,
+            exact_hits: AtomicU64::new(0),
+            covered_hits: AtomicU64::new(0),
+            misses: AtomicU64::new(0),
+        })
+    }
+
+    /// Flattens the recorded reads into non-overlapping pieces, preferring the earliest
+    /// recording where reads overlap.
+    fn build_pieces(mut recorded: Vec<(usize, usize, usize)>) -> Vec<Piece> {
+        recorded.sort_by_key(|&(start, _, _)| start);
+
+        let mut pieces: Vec<Piece> = Vec::with_capacity(recorded.len());
+
+        let mut covered_end = 0;
+
+        for (start, end, data_offset) in recorded {
+            if end <= covered_end {
+                continue;
+            }
+
+            let piece_start = start.max(covered_end);
+
+            pieces.push(Piece {
+                start: piece_start,
+                end,
+                data_offset: data_offset + (piece_start - start),
+            });
+
+            covered_end = end;
+        }
+
+        pieces
+    }
+
+    fn read_covered(&self, address: usize, buffer: &mut [u8]) -> bool {
+        let end = address + buffer.len();
+
+        let mut index = match self
+            .pieces
+            .partition_point(|piece| piece.start <= address)
+            .checked_sub(1)
+        {
+            Some(index) => index,
+            None => return false,
+        };
+
+        let mut current = address;
+
+        while current < end {
+            let piece = match self.pieces.get(index) {
+                Some(piece) if piece.start <= current && current < piece.end => piece,
+                _ => return false,
+            };
+
+            let stop = end.min(piece.end);
+            let offset = piece.data_offset + (current - piece.start);
+
+            buffer[current - address..stop - address]
+                .copy_from_slice(&self.data[offset..offset + (stop - current)]);
+
+            current = stop;
+            index += 1;
+        }
+
+        true
+    }
+}
+
+impl MemorySource for ReplayMemorySource {
+    fn read_memory(&self, address: usize, buffer: &mut [u8]) -> Result<()> {
+        match self.index.get(&(address, buffer.len())) {
+            Some(Some(data_offset)) => {
+                self.exact_hits.fetch_add(1, Ordering::Relaxed);
+
+                buffer.copy_from_slice(&self.data[*data_offset..*data_offset + buffer.len()]);
+
+                Ok(())
+            }
+            Some(None) => {
+                self.exact_hits.fetch_add(1, Ordering::Relaxed);
+
+                Err(Error::InvalidAddress(address))
+            }
+            None if self.read_covered(address, buffer) => {
+                self.covered_hits.fetch_add(1, Ordering::Relaxed);
+
+                Ok(())
+            }
+            None => {
+                self.misses.fetch_add(1, Ordering::Relaxed);
+
+                Err(Error::InvalidAddress(address))
+            }
+        }
+    }
+
+    fn modules(&self) -> Result<Vec<ModuleEntry>> {
+        Ok(self.modules.clone())
+    }
+
+    fn regions(&self) -> Result<Vec<MemoryRegion>> {
+        self.regions
+            .clone()
+            .ok_or(Error::Unsupported("querying memory regions"))
+    }
+}
+
+impl Drop for ReplayMemorySource {
+    fn drop(&mut self) {
+        let exact_hits = *self.exact_hits.get_mut();
+        let covered_hits = *self.covered_hits.get_mut();
+        let misses = *self.misses.get_mut();
+
+        log::info!(
+            "Replayed {} reads against {} recorded ({} exact, {} covered by other reads, {} missing).",
+            exact_hits + covered_hits + misses,
+            self.recorded_reads,
+            exact_hits,
+            covered_hits,
+            misses
+        );
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use std::env;
+
+    use super::*;
+
+    use crate::remote::{Process, RecordingMemorySource};
+    use crate::sdk::mock_schema_system::MockSchemaSystem;
+    use crate::sdk::SchemaSystem;
+    use crate::session::Session;
+
+    fn class_names(process: Process) -> Result<Vec<String>> {
+        let session = Session::new(process)?;
+
+        let mut names = Vec::new();
+
+        for type_scope in SchemaSystem::new(&session)?.type_scopes()? {
+            for class in type_scope.classes()? {
+                names.push(class.name().to_string());
+            }
+        }
+
+        Ok(names)
+    }
+
+    #[test]
+    fn record_and_replay() -> Result<()> {
+        let path = env::temp_dir().join(format!("cs2-dumper-{}.trace", std::process::id()));
+
+        let mock = MockSchemaSystem::generate(2, 300);
+
+        let recorded = {
+            let source = RecordingMemorySource::new(Box::new(mock.build()), &path)?;
+
+            class_names(Process::with_source(source))?
+        };
+
+        let replayed = class_names(Process::with_source(ReplayMemorySource::new(&path)?))?;
+
+        std::fs::remove_file(&path)?;
+
+        assert_eq!(recorded.len(), 600);
+        assert_eq!(recorded, replayed);
+
+        Ok(())
+    }
+
+    #[test]
+    fn reject_overflowing_index_entries() -> Result<()> {
+        let path = env::temp_dir().join(format!("cs2-dumper-{}-corrupt.trace", std::process::id()));
+
+        {
+            let source = RecordingMemorySource::new(
+                Box::new(MockSchemaSystem::generate(1, 1).build()),
+                &path,
+            )?;
+
+            class_names(Process::with_source(source))?;
+        }
+
+        let mut trace = std::fs::read(&path)?;
+
+        let footer = trace.len() - TRACE_FOOTER_SIZE;
+        let index_offset =
+            u64::from_le_bytes(trace[footer + 16..footer + 24].try_into().unwrap()) as usize;
+
+        // The first entry starts after the entry count; its address is followed by the size, the
+        // status byte and the data offset.
+        let entry = index_offset + 4;
+
+        trace[entry + 12] = 1;
+
+        let mut patched = trace.clone();
+        patched[entry + 13..entry + 21].copy_from_slice(&u64::MAX.to_le_bytes());
+        std::fs::write(&path, &patched)?;
+
+        let data_offset = ReplayMemorySource::new(&path).err();
+
+        let mut patched = trace;
+        patched[entry..entry + 8].copy_from_slice(&u64::MAX.to_le_bytes());
+        std::fs::write(&path, &patched)?;
+
+        let address = ReplayMemorySource::new(&path).err();
+
+        std::fs::remove_file(&path)?;
+
+        assert!(matches!(
+            data_offset,
+            Some(Error::BufferSizeMismatch(usize::MAX, _))
+        ));
+        assert!(matches!(address, Some(Error::InvalidAddress(usize::MAX))));
+
+        Ok(())
+    }
+}
@@ -0,0 +1,231 @@
+use std::fs::File;
+use std::path::Path;
+use std::sync::{Arc, Mutex};
+
+use memmap2::Mmap;
+
+use crate::error::{Error, Result};
+use crate::mem::{ByteReader, MemoryRegion, Protection};
+
+use super::capture_memory_source::{SNAPSHOT_FOOTER_SIZE, SNAPSHOT_MAGIC, SNAPSHOT_VERSION};
+use super::{MemorySource, ModuleEntry};
+
+/// Number of decompressed blocks kept around for subsequent reads.
+const CACHED_BLOCKS: usize = 32;
+
+struct Block {
+    address: usize,
+    size: usize,
+    protection: Protection,
+    data_offset: usize,
+    compressed_size: usize,
+}
+
+/// Serves reads from a snapshot written by `CaptureMemorySource`.
+///
+/// The file is memory-mapped and a block is only decompressed when a read touches it. The most
+/// recently used blocks are cached, so memory use stays bounded regardless of the snapshot size.
+pub struct SnapshotMemorySource {
+    data: Mmap,
+    blocks: Vec<Block>,
+    modules: Vec<ModuleEntry>,
+    cache: Mutex<Vec<(usize, Arc<Vec<u8>>)>>,
+}
+
+impl SnapshotMemorySource {
+    pub fn new(path: &Path) -> Result<Self> {
+        let file = File::open(path)?;
+
+        let data = unsafe { Mmap::map(&file) }?;
+
+        let mut reader = ByteReader::new(&data);
+
+        if reader.bytes(SNAPSHOT_MAGIC.len())? != SNAPSHOT_MAGIC {
+            return Err(Error::InvalidMagic(0));
+        }
+
+        let version = reader.u32()?;
+
+        if version != SNAPSHOT_VERSION {
+            return Err(Error::InvalidMagic(version));
+        }
+
+        reader.position = data
+            .len()
+            .checked_sub(SNAPSHOT_FOOTER_SIZE)
+            .ok_or(Error::BufferSizeMismatch(SNAPSHOT_FOOTER_SIZE, data.len()))?;
+
+        let index_offset = reader.u64()? as usize;
+
+        if reader.bytes(SNAPSHOT_MAGIC.len())? != SNAPSHOT_MAGIC {
+            return Err(Error::InvalidMagic(0));
+        }
+
+        reader.position = index_offset;
+
+        let modules = (0..reader.u32()?)
+            .map(|_| {
+                let name_len = reader.u16()? as usize;
+                let name = String::from_utf8(reader.bytes(name_len)?.to_vec())?;
+
+                Ok(ModuleEntry {
+                    name,
+                    base: reader.u64()? as usize,
+                    size: reader.u64()? as usize,
+                })
+            })
+            .collect::<Result<Vec<_>>>()?;
+
+        let mut blocks = (0..reader.u32()?)
+            .map(|_| {
+                let block = Block {
+                    address: reader.u64()? as usize,
+                    size: reader.u32()? as usize,
+                    protection: Protection::from_bits(reader.bytes(1)?[0]),
+                    data_offset: reader.u64()? as usize,
+                    compressed_size: reader.u32()? as usize,
+                };
+
+                let end = block.data_offset.saturating_add(block.compressed_size);
+
+                if end > index_offset {
+                    return Err(Error::BufferSizeMismatch(end, index_offset));
+                }
+
+                Ok(block)
+            })
+            .collect::<Result<Vec<_>>>()?;
+
+        blocks.sort_by_key(|block| block.address);
+
+        Ok(Self {
+            data,
+            blocks,
+            modules,
+            cache: Mutex::new(Vec::with_capacity(CACHED_BLOCKS)),
+        })
+    }
+
+    /// Returns the decompressed contents of the block at `index`.
+    fn block(&self, index: usize) -> Result<Arc<Vec<u8>>> {
+        let mut cache = self.cache.lock().unwrap();
+
+        if let Some(position) = cache.iter().position(|&(cached, _)| cached == index) {
+            let entry = cache.remove(position);
+
+            let data = entry.1.clone();
+
+            cache.push(entry);
+
+            return Ok(data);
+        }
+
+        let block = &self.blocks[index];
+
+        let compressed = &self.data[block.data_offset..block.data_offset + block.compressed_size];
+
+        let data = Arc::new(zstd::bulk::decompress(compressed, block.size)?);
+
+        if data.len() != block.size {
+            return Err(Error::BufferSizeMismatch(block.size, data.len()));
+        }
+
+        if cache.len() == CACHED_BLOCKS {
+            cache.remove(0);
+        }
+
+        cache.push((index, data.clone()));
+
+        Ok(data)
+    }
+}
+
+impl MemorySource for SnapshotMemorySource {
+    fn read_memory(&self, address: usize, buffer: &mut [u8]) -> Result<()> {
+        let mut index = self
+            .blocks
+            .partition_point(|block| block.address + block.size <= address);
+
+        let mut position = 0;
+
+        // A read may span several adjacent blocks, but never a gap between them.
+        while position < buffer.len() {
+            let current = address + position;
+
+            let block = self
+                .blocks
+                .get(index)
+                .filter(|block| block.address <= current)
+                .ok_or(Error::InvalidAddress(current))?;
+
+            let data = self.block(index)?;
+
+            let offset = current - block.address;
+            let len = (block.size - offset).min(buffer.len() - position);
+
+            buffer[position..position + len].copy_from_slice(&data[offset..offset + len]);
+
+            position += len;
+            index += 1;
+        }
+
+        Ok(())
+    }
+
+    fn modules(&self) -> Result<Vec<ModuleEntry>> {
+        Ok(self.modules.clone())
+    }
+
+    fn regions(&self) -> Result<Vec<MemoryRegion>> {
+        Ok(self
+            .blocks
+            .iter()
+            .map(|block| MemoryRegion {
+                start: block.address,
+                end: block.address + block.size,
+                protection: block.protection,
+            })
+            .collect())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use std::env;
+
+    use super::*;
+
+    use crate::remote::{CaptureMemorySource, Process};
+    use crate::schema::SchemaDatabase;
+    use crate::sdk::mock_schema_system::MockSchemaSystem;
+    use crate::session::Session;
+
+    #[test]
+    fn capture_and_read() -> Result<()> {
+        let path = env::temp_dir().join(format!("cs2-dumper-{}.snapshot", std::process::id()));
+
+        let mock = MockSchemaSystem::generate(2, 300);
+
+        let captured = {
+            let source = CaptureMemorySource::new(Box::new(mock.build()), &path)?;
+
+            SchemaDatabase::collect(&Session::new(Process::with_source(source))?)?
+        };
+
+        let snapshot = SchemaDatabase::collect(&Session::new(Process::with_source(
+            SnapshotMemorySource::new(&path)?,
+        ))?)?;
+
+        std::fs::remove_file(&path)?;
+
+        assert_eq!(captured.class_count(), 600);
+        assert_eq!(snapshot.class_count(), captured.class_count());
+
+        for class in 0..captured.class_count() {
+            assert_eq!(snapshot.class_name(class), captured.class_name(class));
+            assert_eq!(snapshot.class_fields(class), captured.class_fields(class));
+        }
+
+        Ok(())
+    }
+}
@@ -0,0 +1,3 @@
+pub use schema_database::SchemaDatabase;
+
+pub mod schema_database;
@@ -0,0 +1,579 @@
+use std::collections::HashMap;
+use std::fs::{self, File};
+use std::io::{BufWriter, Write};
+use std::ops::Range;
+use std::path::Path;
+
+use crate::builder::{ClassLayout, ClassLayouts, FieldLayout};
+use crate::dumpers::{Entries, Entry};
+use crate::error::{Error, Result};
+use crate::mem::ByteReader;
+use crate::sdk::SchemaSystem;
+use crate::session::Session;
+
+pub const CACHE_MAGIC: &[u8; 8] = b"CS2SCHEM";
+pub const CACHE_VERSION: u32 = 1;
+
+/// Marks a missing parent class.
+const NO_INDEX: u32 = u32::MAX;
+
+/// Every module, class, field and type read from the schema system, stored in flat vectors that
+/// reference each other by index.
+///
+/// The database is read from the process once and all file builders render from it, so it can
+/// also be saved to a cache file and rendered again later without the game running.
+#[derive(Debug, Default, PartialEq)]
+pub struct SchemaDatabase {
+    module_names: Vec<String>,
+    module_classes: Vec<(u32, u32)>,
+
+    class_names: Vec<String>,
+    class_modules: Vec<u32>,
+    class_sizes: Vec<u32>,
+    class_parents: Vec<u32>,
+    class_fields: Vec<(u32, u32)>,
+
+    field_names: Vec<String>,
+    field_offsets: Vec<u32>,
+    field_types: Vec<u32>,
+
+    type_names: Vec<String>,
+    type_sizes: Vec<u32>,
+}
+
+impl SchemaDatabase {
+    pub fn collect(session: &Session) -> Result<Self> {
+        Self::read(session, None)
+    }
+
+    /// Like `collect`, but calls `on_module` as soon as each module has been read.
+    ///
+    /// Parents and type sizes are resolved against the modules read so far when `on_module` is
+    /// called, so classes that refer to a later module only get their final layout once
+    /// everything has been read.
+    pub fn collect_with<F>(session: &Session, mut on_module: F) -> Result<Self>
+    where
+        F: FnMut(&Self, usize),
+    {
+        Self::read(session, Some(&mut on_module))
+    }
+
+    fn read(
+        session: &Session,
+        mut on_module: Option<&mut dyn FnMut(&Self, usize)>,
+    ) -> Result<Self> {
+        let schema_system = SchemaSystem::new(session)?;
+
+        let mut database = Self::default();
+
+        let mut parent_names: Vec<Option<String>> = Vec::new();
+        let mut type_indices: HashMap<String, u32> = HashMap::new();
+
+        for type_scope in schema_system.type_scopes()? {
+            let module_name = type_scope.module_name()?;
+
+            log::info!("Reading classes from {}...", module_name);
+
+            let module_index = database.module_names.len() as u32;
+            let first_class = database.class_names.len() as u32;
+
+            for class in type_scope.classes()? {
+                log::debug!("  {}", class.name());
+
+                let first_field = database.field_names.len() as u32;
+
+                for field in class.fields()? {
+                    let field_name = field.name()?;
+                    let field_offset = field.offset()?;
+                    let field_type_name = field.r#type()?.name()?;
+
+                    log::debug!(
+                        "    └─ {} = {:#X} // {}",
+                        field_name,
+                        field_offset,
+                        field_type_name
+                    );
+
+                    let type_index =
+                        *type_indices
+                            .entry(field_type_name)
+                            .or_insert_with_key(|name| {
+                                database.type_names.push(name.clone());
+
+                                (database.type_names.len() - 1) as u32
+                            });
+
+                    database.field_names.push(field_name);
+                    database.field_offsets.push(field_offset as u32);
+                    database.field_types.push(type_index);
+                }
+
+                database.class_names.push(class.name().to_string());
+                database.class_modules.push(module_index);
+                database.class_sizes.push(class.size()?.max(0) as u32);
+                database
+                    .class_fields
+                    .push((first_field, database.field_names.len() as u32));
+
+                parent_names.push(class.parent()?.map(|parent| parent.name().to_string()));
+            }
+
+            database.module_names.push(module_name);
+            database
+                .module_classes
+                .push((first_class, database.class_names.len() as u32));
+
+            if let Some(on_module) = on_module.as_mut() {
+                database.resolve_parents(&parent_names);
+                database.resolve_type_sizes();
+
+                on_module(&database, module_index as usize);
+            }
+        }
+
+        database.resolve_parents(&parent_names);
+        database.resolve_type_sizes();
+
+        Ok(database)
+    }
+
+    /// Links each class to its parent, preferring a class of the same name in the same module.
+    fn resolve_parents(&mut self, parent_names: &[Option<String>]) {
+        let mut by_name: HashMap<&str, u32> = HashMap::new();
+        let mut by_module: HashMap<(u32, &str), u32> = HashMap::new();
+
+        for (index, name) in self.class_names.iter().enumerate() {
+            by_name.entry(name).or_insert(index as u32);
+            by_module
+                .entry((self.class_modules[index], name))
+                .or_insert(index as u32);
+        }
+
+        self.class_parents = parent_names
+            .iter()
+            .enumerate()
+            .map(|(index, parent_name)| {
+                parent_name
+                    .as_deref()
+                    .and_then(|name| {
+                        by_module
+                            .get(&(self.class_modules[index], name))
+                            .or_else(|| by_name.get(name))
+                    })
+                    .copied()
+                    .unwrap_or(NO_INDEX)
+            })
+            .collect();
+    }
+
+    /// Works out the size of every field type from its name. Types whose size can't be derived
+    /// are left at 0.
+    fn resolve_type_sizes(&mut self) {
+        let class_sizes: HashMap<&str, u32> = self
+            .class_names
+            .iter()
+            .zip(&self.class_sizes)
+            .map(|(name, &size)| (name.as_str(), size))
+            .collect();
+
+        self.type_sizes = self
+            .type_names
+            .iter()
+            .map(|name| type_size(name, &class_sizes).unwrap_or(0))
+            .collect();
+    }
+
+    #[inline]
+    pub fn module_count(&self) -> usize {
+        self.module_names.len()
+    }
+
+    #[inline]
+    pub fn module_name(&self, module: usize) -> &str {
+        &self.module_names[module]
+    }
+
+    #[inline]
+    pub fn module_classes(&self, module: usize) -> Range<usize> {
+        let (start, end) = self.module_classes[module];
+
+        start as usize..end as usize
+    }
+
+    #[inline]
+    pub fn class_count(&self) -> usize {
+        self.class_names.len()
+    }
+
+    #[inline]
+    pub fn class_name(&self, class: usize) -> &str {
+        &self.class_names[class]
+    }
+
+    #[inline]
+    pub fn class_module(&self, class: usize) -> usize {
+        self.class_modules[class] as usize
+    }
+
+    #[inline]
+    pub fn class_size(&self, class: usize) -> usize {
+        self.class_sizes[class] as usize
+    }
+
+    #[inline]
+    pub fn class_parent(&self, class: usize) -> Option<usize> {
+        match self.class_parents[class] {
+            NO_INDEX => None,
+            parent => Some(parent as usize),
+        }
+    }
+
+    #[inline]
+    pub fn class_fields(&self, class: usize) -> Range<usize> {
+        let (start, end) = self.class_fields[class];
+
+        start as usize..end as usize
+    }
+
+    #[inline]
+    pub fn field_name(&self, field: usize) -> &str {
+        &self.field_names[field]
+    }
+
+    #[inline]
+    pub fn field_offset(&self, field: usize) -> usize {
+        self.field_offsets[field] as usize
+    }
+
+    #[inline]
+    pub fn field_type(&self, field: usize) -> usize {
+        self.field_types[field] as usize
+    }
+
+    #[inline]
+    pub fn type_name(&self, r#type: usize) -> &str {
+        &self.type_names[r#type]
+    }
+
+    #[inline]
+    pub fn type_size(&self, r#type: usize) -> Option<usize> {
+        match self.type_sizes[r#type] {
+            0 => None,
+            size => Some(size as usize),
+        }
+    }
+
+    /// Returns the fields of a module grouped by class, in the form the file builders render.
+    pub fn entries(&self, module: usize) -> Entries {
+        let mut entries = Entries::new();
+
+        for class in self.module_classes(module) {
+            for field in self.class_fields(class) {
+                entries
+                    .entry(self.class_name(class).replace("::", "_"))
+                    .or_default()
+                    .push(Entry {
+                        name: self.field_name(field).to_string(),
+                        value: self.field_offset(field),
+                        comment: Some(self.type_name(self.field_type(field)).to_string()),
+                    });
+            }
+        }
+
+        entries
+    }
+
+    /// Returns the layout of every class in a module that has fields, keyed like `entries`.
+    pub fn layouts(&self, module: usize) -> ClassLayouts {
+        let mut layouts = ClassLayouts::new();
+
+        for class in self.module_classes(module) {
+            if self.class_fields(class).is_empty() {
+                continue;
+            }
+
+            layouts
+                .entry(self.class_name(class).replace("::", "_"))
+                .or_insert_with(|| ClassLayout {
+                    size: self.class_size(class),
+                    parent: self
+                        .class_parent(class)
+                        .map(|parent| self.class_name(parent).to_string()),
+                    fields: self
+                        .class_fields(class)
+                        .map(|field| FieldLayout {
+                            name: self.field_name(field).to_string(),
+                            offset: self.field_offset(field),
+                            size: self.type_size(self.field_type(field)),
+                            type_name: self.type_name(self.field_type(field)).to_string(),
+                        })
+                        .collect(),
+                    read_spans: Vec::new(),
+                });
+        }
+
+        layouts
+    }
+
+    pub fn save(&self, path: &Path) -> Result<()> {
+        let mut writer = BufWriter::new(File::create(path)?);
+
+        writer.write_all(CACHE_MAGIC)?;
+        writer.write_all(&CACHE_VERSION.to_le_bytes())?;
+
+        write_strings(&mut writer, &self.module_names)?;
+        write_ranges(&mut writer, &self.module_classes)?;
+
+        write_strings(&mut writer, &self.class_names)?;
+        write_u32s(&mut writer, &self.class_modules)?;
+        write_u32s(&mut writer, &self.class_sizes)?;
+        write_u32s(&mut writer, &self.class_parents)?;
+        write_ranges(&mut writer, &self.class_fields)?;
+
+        write_strings(&mut writer, &self.field_names)?;
+        write_u32s(&mut writer, &self.field_offsets)?;
+        write_u32s(&mut writer, &self.field_types)?;
+
+        write_strings(&mut writer, &self.type_names)?;
+        write_u32s(&mut writer, &self.type_sizes)?;
+
+        writer.flush()?;
+
+        Ok(())
+    }
+
+    pub fn load(path: &Path) -> Result<Self> {
+        let data = fs::read(path)?;
+
+        let mut reader = ByteReader::new(&data);
+
+        if reader.bytes(CACHE_MAGIC.len())? != CACHE_MAGIC {
+            return Err(Error::InvalidMagic(0));
+        }
+
+        let version = reader.u32()?;
+
+        if version != CACHE_VERSION {
+            return Err(Error::InvalidMagic(version));
+        }
+
+        let database = Self {
+            module_names: read_strings(&mut reader)?,
+            module_classes: read_ranges(&mut reader)?,
+            class_names: read_strings(&mut reader)?,
+            class_modules: read_u32s(&mut reader)?,
+            class_sizes: read_u32s(&mut reader)?,
+            class_parents: read_u32s(&mut reader)?,
+            class_fields: read_ranges(&mut reader)?,
+            field_names: read_strings(&mut reader)?,
+            field_offsets: read_u32s(&mut reader)?,
+            field_types: read_u32s(&mut reader)?,
+            type_names: read_strings(&mut reader)?,
+            type_sizes: read_u32s(&mut reader)?,
+        };
+
+        database.validate()?;
+
+        Ok(database)
+    }
+
+    /// Checks that the columns of each table line up and that every stored index is in range.
+    fn validate(&self) -> Result<()> {
+        let modules = self.module_names.len();
+        let classes = self.class_names.len();
+        let fields = self.field_names.len();
+        let types = self.type_names.len();
+
+        let columns = [
+            (self.module_classes.len(), modules),
+            (self.class_modules.len(), classes),
+            (self.class_sizes.len(), classes),
+            (self.class_parents.len(), classes),
+            (self.class_fields.len(), classes),
+            (self.field_offsets.len(), fields),
+            (self.field_types.len(), fields),
+            (self.type_sizes.len(), types),
+        ];
+
+        for (len, expected) in columns {
+            if len != expected {
+                return Err(Error::BufferSizeMismatch(expected, len));
+            }
+        }
+
+        let ranges = self
+            .module_classes
+            .iter()
+            .map(|&range| (range, classes))
+            .chain(self.class_fields.iter().map(|&range| (range, fields)));
+
+        for ((start, end), len) in ranges {
+            if start > end || end as usize > len {
+                return Err(Error::BufferSizeMismatch(end as usize, len));
+            }
+        }
+
+        let indices = self
+            .class_modules
+            .iter()
+            .map(|&index| (index, modules))
+            .chain(
+                self.class_parents
+                    .iter()
+                    .filter(|&&index| index != NO_INDEX)
+                    .map(|&index| (index, classes)),
+            )
+            .chain(self.field_types.iter().map(|&index| (index, types)));
+
+        for (index, len) in indices {
+            if index as usize >= len {
+                return Err(Error::BufferSizeMismatch(index as usize, len));
+            }
+        }
+
+        Ok(())
+    }
+}
+
+/// Returns the size of a schema type from its name, looking up class types in `class_sizes`.
+fn type_size(name: &str, class_sizes: &HashMap<&str, u32>) -> Option<u32> {
+    let name = name.trim();
+
+    if name.ends_with('*') {
+        return Some(8);
+    }
+
+    if let Some(open) = name.rfind('[').filter(|_| name.ends_with(']')) {
+        let count = name[open + 1..name.len() - 1].trim().parse::<u32>().ok()?;
+
+        return type_size(&name[..open], class_sizes)?.checked_mul(count);
+    }
+
+    let size = match name {
+        "bool" | "char" | "int8" | "uint8" | "int8_t" | "uint8_t" => 1,
+        "int16" | "uint16" | "int16_t" | "uint16_t" => 2,
+        "int32" | "uint32" | "int32_t" | "uint32_t" | "float" | "float32" => 4,
+        "int64" | "uint64" | "int64_t" | "uint64_t" | "double" | "float64" => 8,
+        "Color" | "GameTick_t" | "GameTime_t" | "CEntityHandle" => 4,
+        "Vector2D" | "CUtlString" | "CUtlSymbolLarge" | "CGlobalSymbol" => 8,
+        "Vector" | "QAngle" | "RotationVector" => 12,
+        "Vector4D" | "Quaternion" => 16,
+        "CTransform" => 32,
+        "matrix3x4_t" => 48,
+        _ if name.starts_with("CHandle<") => 4,
+        _ if name.starts_with("CUtlVector<") => 24,
+        _ => *class_sizes.get(name)?,
+    };
+
+    Some(size)
+}
+
+fn write_u32s(writer: &mut impl Write, values: &[u32]) -> Result<()> {
+    writer.write_all(&(values.len() as u32).to_le_bytes())?;
+
+    for value in values {
+        writer.write_all(&value.to_le_bytes())?;
+    }
+
+    Ok(())
+}
+
+fn write_ranges(writer: &mut impl Write, ranges: &[(u32, u32)]) -> Result<()> {
+    writer.write_all(&(ranges.len() as u32).to_le_bytes())?;
+
+    for (start, end) in ranges {
+        writer.write_all(&start.to_le_bytes())?;
+        writer.write_all(&end.to_le_bytes())?;
+    }
+
+    Ok(())
+}
+
+fn write_strings(writer: &mut impl Write, strings: &[String]) -> Result<()> {
+    writer.write_all(&(strings.len() as u32).to_le_bytes())?;
+
+    for string in strings {
+        writer.write_all(&(string.len() as u32).to_le_bytes())?;
+        writer.write_all(string.as_bytes())?;
+    }
+
+    Ok(())
+}
+
+fn read_u32s(reader: &mut ByteReader) -> Result<Vec<u32>> {
+    (0..reader.u32()?).map(|_| reader.u32()).collect()
+}
+
+fn read_ranges(reader: &mut ByteReader) -> Result<Vec<(u32, u32)>> {
+    (0..reader.u32()?)
+        .map(|_| Ok((reader.u32()?, reader.u32()?)))
+        .collect()
+}
+
+fn read_strings(reader: &mut ByteReader) -> Result<Vec<String>> {
+    (0..reader.u32()?)
+        .map(|_| {
+            let len = reader.u32()? as usize;
+
+            Ok(String::from_utf8(reader.bytes(len)?.to_vec())?)
+        })
+        .collect()
+}
+
+#[cfg(test)]
+mod tests {
+    use std::env;
+
+    use super::*;
+
+    use crate::remote::Process;
+    use crate::sdk::mock_schema_system::MockSchemaSystem;
+
+    #[test]
+    fn collect_and_reload() -> Result<()> {
+        let mock = MockSchemaSystem::generate(3, 200);
+
+        let database = SchemaDatabase::collect(&Session::new(Process::with_source(mock.build()))?)?;
+
+        assert_eq!(database.module_count(), 3);
+        assert_eq!(database.class_count(), 600);
+
+        for (scope_index, scope) in mock.type_scopes.iter().enumerate() {
+            let classes = database.module_classes(scope_index);
+
+            assert_eq!(database.module_name(scope_index), scope.module_name);
+            assert_eq!(classes.len(), scope.classes.len());
+
+            for class in classes {
+                let mock_class = scope
+                    .classes
+                    .iter()
+                    .find(|mock_class| mock_class.name == database.class_name(class))
+                    .unwrap();
+
+                assert_eq!(database.class_size(class), mock_class.size as usize);
+                assert_eq!(
+                    database
+                        .class_parent(class)
+                        .map(|parent| database.class_name(parent)),
+                    mock_class
+                        .parent
+                        .map(|parent| scope.classes[parent].name.as_str())
+                );
+                assert_eq!(database.class_fields(class).len(), mock_class.fields.len());
+            }
+        }
+
+        let path = env::temp_dir().join(format!("cs2-dumper-{}.schema", std::process::id()));
+
+        database.save(&path)?;
+
+        let reloaded = SchemaDatabase::load(&path);
+
+        std::fs::remove_file(&path)?;
+
+        assert_eq!(database, reloaded?);
+
+        Ok(())
+    }
+}
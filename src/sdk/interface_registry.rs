@@ -0,0 +1,50 @@
+use std::collections::HashSet;
+
+use crate::error::Result;
+use crate::remote::{Module, Process};
+
+/// A node of the `InterfaceReg` list, read as a single record.
+#[derive(Clone, Copy, Debug)]
+#[repr(C)]
+pub struct InterfaceReg {
+    pub create_fn: usize,
+    pub name: usize,
+    pub next: usize,
+}
+
+/// The interfaces a module registers with `CreateInterface`.
+pub struct InterfaceRegistry {
+    regs: Vec<InterfaceReg>,
+}
+
+impl InterfaceRegistry {
+    /// Walks the registry of `module`, or returns `None` if it doesn't export `CreateInterface`.
+    pub fn new(process: &Process, module: &Module) -> Result<Option<Self>> {
+        let Some(create_interface) = module.export("CreateInterface") else {
+            return Ok(None);
+        };
+
+        let head = process.resolve_rip(create_interface.va, None, None)?;
+
+        let mut address = process.read_memory::<usize>(head).unwrap_or(0);
+
+        let mut regs = Vec::new();
+        let mut visited = HashSet::new();
+
+        // A corrupted list could loop back on itself.
+        while address != 0 && visited.insert(address) {
+            let reg = process.read_memory::<InterfaceReg>(address)?;
+
+            regs.push(reg);
+
+            address = reg.next;
+        }
+
+        Ok(Some(Self { regs }))
+    }
+
+    #[inline]
+    pub fn regs(&self) -> &[InterfaceReg] {
+        &self.regs
+    }
+}
@@ -0,0 +1,544 @@
+use std::collections::HashMap;
+use std::time::Instant;
+
+use crate::error::Result;
+use crate::remote::{BufferMemorySource, Process};
+use crate::session::Session;
+
+use super::SchemaSystem;
+
+const MODULE_BASE: usize = 0x180000000;
+const MODULE_SIZE: usize = 0x3000;
+const HEAP_BASE: usize = 0x20000000000;
+
+const CODE_RVA: usize = 0x1000;
+const CREATE_INTERFACE_RVA: usize = 0x1100;
+const SCHEMA_SYSTEM_FACTORY_RVA: usize = 0x1200;
+const SCHEMA_SYSTEM_RVA: usize = 0x2000;
+const EXPORT_DIRECTORY_RVA: usize = 0x2800;
+const EXPORT_DIRECTORY_SIZE: usize = 0x50;
+const INTERFACE_REGS_RVA: usize = 0x2900;
+
+const BLOCKS_PER_BLOB: usize = 256;
+const HASH_BUCKET_SIZE: usize = 0x18;
+
+const TYPES: &[(&str, u32, u32)] = &[
+    ("bool", 1, 1),
+    ("uint8", 1, 1),
+    ("int16", 2, 2),
+    ("int32", 4, 4),
+    ("uint32", 4, 4),
+    ("float32", 4, 4),
+    ("CHandle< C_BaseEntity >", 4, 4),
+    ("int64", 8, 8),
+    ("uint64", 8, 8),
+    ("C_BaseEntity*", 8, 8),
+    ("CUtlString", 8, 8),
+    ("Vector", 12, 4),
+    ("QAngle", 12, 4),
+    ("float32[4]", 16, 4),
+    ("CUtlVector< int32 >", 24, 8),
+];
+
+pub struct MockField {
+    pub name: String,
+    pub type_name: String,
+    pub offset: u16,
+}
+
+pub struct MockClass {
+    pub name: String,
+    pub size: u32,
+    pub parent: Option<usize>,
+    pub fields: Vec<MockField>,
+}
+
+pub struct MockTypeScope {
+    pub module_name: String,
+    pub classes: Vec<MockClass>,
+}
+
+/// Describes a schema system and lays it out in memory the way the game does, so the SDK walkers
+/// can be exercised without a running game.
+pub struct MockSchemaSystem {
+    pub type_scopes: Vec<MockTypeScope>,
+    /// Registers `CSchemaSystem` as `SchemaSystem_001` with `CreateInterface`.
+    pub register_interface: bool,
+}
+
+impl MockSchemaSystem {
+    /// Generates `scope_count` type scopes of `class_count` classes each, with between 1 and 16
+    /// fields per class. The output only depends on the arguments.
+    pub fn generate(scope_count: usize, class_count: usize) -> Self {
+        let mut seed: u64 = 0x9E3779B97F4A7C15;
+
+        let mut random = move |bound: usize| {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+
+            (seed % bound as u64) as usize
+        };
+
+        let type_scopes = (0..scope_count)
+            .map(|scope_index| {
+                let classes = (0..class_count)
+                    .map(|class_index| {
+                        let mut offset = 0;
+
+                        let fields = (0..1 + random(16))
+                            .map(|field_index| {
+                                let (type_name, size, alignment) = TYPES[random(TYPES.len())];
+
+                                offset = (offset + alignment - 1) / alignment * alignment;
+
+                                let field = MockField {
+                                    name: format!("m_field{}", field_index),
+                                    type_name: type_name.to_string(),
+                                    offset: offset as u16,
+                                };
+
+                                offset += size;
+
+                                field
+                            })
+                            .collect();
+
+                        MockClass {
+                            name: format!("C_Mock{}_{}", scope_index, class_index),
+                            size: (offset + 7) / 8 * 8,
+                            parent: class_index.checked_sub(1 + random(4)),
+                            fields,
+                        }
+                    })
+                    .collect();
+
+                MockTypeScope {
+                    module_name: format!("mock{}.dll", scope_index),
+                    classes,
+                }
+            })
+            .collect();
+
+        Self {
+            type_scopes,
+            register_interface: true,
+        }
+    }
+
+    pub fn class_count(&self) -> usize {
+        self.type_scopes
+            .iter()
+            .map(|type_scope| type_scope.classes.len())
+            .sum()
+    }
+
+    pub fn build(&self) -> BufferMemorySource {
+        let mut heap = Heap::new(HEAP_BASE);
+
+        let mut image = vec![0; MODULE_SIZE];
+
+        write_pe_headers(&mut image);
+
+        // The signature `SchemaSystem::new` scans for, with the first `lea` pointing at the
+        // `CSchemaSystem` global.
+        let code: [u8; 36] = [
+            0x48, 0x8D, 0x0D, 0x00, 0x00, 0x00, 0x00, 0xE9, 0x00, 0x00, 0x00, 0x00, 0xCC, 0xCC,
+            0xCC, 0xCC, 0x48, 0x8D, 0x0D, 0x00, 0x00, 0x00, 0x00, 0xE9, 0x00, 0x00, 0x00, 0x00,
+            0xCC, 0xCC, 0xCC, 0xCC, 0x48, 0x83, 0xEC, 0x28,
+        ];
+
+        image[CODE_RVA..CODE_RVA + code.len()].copy_from_slice(&code);
+
+        write(
+            &mut image,
+            CODE_RVA + 3,
+            &((SCHEMA_SYSTEM_RVA - (CODE_RVA + 7)) as u32).to_le_bytes(),
+        );
+
+        // `CreateInterface` loads the head of the interface list, whose only node points at a
+        // factory returning the `CSchemaSystem` global.
+        write(&mut image, CREATE_INTERFACE_RVA, &[0x4C, 0x8B, 0x0D]);
+        write(
+            &mut image,
+            CREATE_INTERFACE_RVA + 3,
+            &((INTERFACE_REGS_RVA - (CREATE_INTERFACE_RVA + 7)) as u32).to_le_bytes(),
+        );
+
+        write(&mut image, SCHEMA_SYSTEM_FACTORY_RVA, &[0x48, 0x8D, 0x05]);
+        write(
+            &mut image,
+            SCHEMA_SYSTEM_FACTORY_RVA + 3,
+            &((SCHEMA_SYSTEM_RVA - (SCHEMA_SYSTEM_FACTORY_RVA + 7)) as u32).to_le_bytes(),
+        );
+        write(&mut image, SCHEMA_SYSTEM_FACTORY_RVA + 7, &[0xC3]);
+
+        if self.register_interface {
+            let reg = heap.alloc(0x18, 8);
+            let name = heap.string("SchemaSystem_001");
+
+            heap.write_u64(reg, (MODULE_BASE + SCHEMA_SYSTEM_FACTORY_RVA) as u64);
+            heap.write_u64(reg + 0x8, name as u64);
+
+            write(&mut image, INTERFACE_REGS_RVA, &(reg as u64).to_le_bytes());
+        }
+
+        let type_scope_addresses: Vec<usize> = self
+            .type_scopes
+            .iter()
+            .map(|type_scope| heap.type_scope(type_scope))
+            .collect();
+
+        let type_scope_array = heap.alloc(type_scope_addresses.len() * 8, 8);
+
+        for (i, &address) in type_scope_addresses.iter().enumerate() {
+            heap.write_u64(type_scope_array + i * 8, address as u64);
+        }
+
+        write(
+            &mut image,
+            SCHEMA_SYSTEM_RVA + 0x190,
+            &(type_scope_addresses.len() as u32).to_le_bytes(),
+        );
+
+        write(
+            &mut image,
+            SCHEMA_SYSTEM_RVA + 0x198,
+            &(type_scope_array as u64).to_le_bytes(),
+        );
+
+        let mut source = BufferMemorySource::new();
+
+        source.add_module("schemasystem.dll", MODULE_BASE, image);
+        source.add_buffer(HEAP_BASE, heap.data);
+
+        source
+    }
+}
+
+struct Heap {
+    base: usize,
+    data: Vec<u8>,
+    strings: HashMap<String, usize>,
+    types: HashMap<String, usize>,
+}
+
+impl Heap {
+    fn new(base: usize) -> Self {
+        Self {
+            base,
+            data: Vec::new(),
+            strings: HashMap::new(),
+            types: HashMap::new(),
+        }
+    }
+
+    fn alloc(&mut self, size: usize, alignment: usize) -> usize {
+        let offset = (self.data.len() + alignment - 1) / alignment * alignment;
+
+        self.data.resize(offset + size, 0);
+
+        self.base + offset
+    }
+
+    fn write_bytes(&mut self, address: usize, bytes: &[u8]) {
+        write(&mut self.data, address - self.base, bytes);
+    }
+
+    fn write_u64(&mut self, address: usize, value: u64) {
+        self.write_bytes(address, &value.to_le_bytes());
+    }
+
+    fn string(&mut self, value: &str) -> usize {
+        if let Some(&address) = self.strings.get(value) {
+            return address;
+        }
+
+        let address = self.alloc(value.len() + 1, 1);
+
+        self.write_bytes(address, value.as_bytes());
+
+        self.strings.insert(value.to_string(), address);
+
+        address
+    }
+
+    fn schema_type(&mut self, name: &str) -> usize {
+        if let Some(&address) = self.types.get(name) {
+            return address;
+        }
+
+        let address = self.alloc(0x20, 8);
+        let name_address = self.string(name);
+
+        self.write_u64(address + 0x8, name_address as u64);
+
+        self.types.insert(name.to_string(), address);
+
+        address
+    }
+
+    fn type_scope(&mut self, type_scope: &MockTypeScope) -> usize {
+        let address = self.alloc(0x600, 8);
+
+        self.write_bytes(address + 0x8, type_scope.module_name.as_bytes());
+
+        let class_addresses: Vec<usize> = type_scope
+            .classes
+            .iter()
+            .map(|_| self.alloc(0x68, 8))
+            .collect();
+
+        for (class, &class_address) in type_scope.classes.iter().zip(&class_addresses) {
+            self.class(class, class_address, &class_addresses);
+        }
+
+        // Classes are only reachable through the unallocated block lists of the hash.
+        let mut next = 0;
+
+        for block in class_addresses.chunks(BLOCKS_PER_BLOB).rev() {
+            let node = self.alloc(0x20 + BLOCKS_PER_BLOB * HASH_BUCKET_SIZE, 8);
+
+            self.write_u64(node, next as u64);
+
+            for (i, &class_address) in block.iter().enumerate() {
+                let bucket = node + 0x20 + i * HASH_BUCKET_SIZE;
+
+                self.write_u64(bucket, class_address as u64);
+                self.write_u64(bucket + 0x10, i as u64);
+            }
+
+            next = node;
+        }
+
+        let hash = address + 0x588;
+
+        self.write_bytes(hash + 0x4, &(BLOCKS_PER_BLOB as i32).to_le_bytes());
+        self.write_bytes(hash + 0x10, &(class_addresses.len() as i32).to_le_bytes());
+        self.write_u64(hash + 0x30, next as u64);
+
+        address
+    }
+
+    fn class(&mut self, class: &MockClass, address: usize, class_addresses: &[usize]) {
+        let name_address = self.string(&class.name);
+
+        let fields_address = self.alloc(class.fields.len() * 0x20, 8);
+
+        for (i, field) in class.fields.iter().enumerate() {
+            let field_address = fields_address + i * 0x20;
+
+            let field_name_address = self.string(&field.name);
+            let type_address = self.schema_type(&field.type_name);
+
+            self.write_u64(field_address, field_name_address as u64);
+            self.write_u64(field_address + 0x8, type_address as u64);
+            self.write_bytes(field_address + 0x10, &field.offset.to_le_bytes());
+        }
+
+        self.write_u64(address + 0x8, name_address as u64);
+        self.write_bytes(address + 0x18, &class.size.to_le_bytes());
+        self.write_bytes(address + 0x1C, &(class.fields.len() as u16).to_le_bytes());
+        self.write_u64(address + 0x28, fields_address as u64);
+
+        if let Some(parent) = class.parent {
+            let base_class_address = self.alloc(0x10, 8);
+
+            self.write_u64(base_class_address + 0x8, class_addresses[parent] as u64);
+
+            self.write_bytes(address + 0x23, &[1]);
+            self.write_u64(address + 0x38, base_class_address as u64);
+        }
+    }
+}
+
+fn write(data: &mut [u8], offset: usize, bytes: &[u8]) {
+    data[offset..offset + bytes.len()].copy_from_slice(bytes);
+}
+
+/// Writes the smallest PE header `Module` accepts: one section spanning the image and an export
+/// directory holding only `CreateInterface`.
+fn write_pe_headers(image: &mut [u8]) {
+    let nt_headers = 0x40;
+    let optional_header = nt_headers + 0x18;
+    let section_header = optional_header + 0xF0;
+
+    write(image, 0x0, b"MZ");
+    write(image, 0x3C, &(nt_headers as u32).to_le_bytes());
+
+    write(image, nt_headers, b"PE\0\0");
+    write(image, nt_headers + 0x4, &0x8664u16.to_le_bytes());
+    write(image, nt_headers + 0x6, &1u16.to_le_bytes());
+    write(image, nt_headers + 0x14, &0xF0u16.to_le_bytes());
+
+    write(image, optional_header, &0x20Bu16.to_le_bytes());
+    write(
+        image,
+        optional_header + 0x18,
+        &(MODULE_BASE as u64).to_le_bytes(),
+    );
+    write(image, optional_header + 0x20, &0x1000u32.to_le_bytes());
+    write(image, optional_header + 0x24, &0x200u32.to_le_bytes());
+    write(
+        image,
+        optional_header + 0x38,
+        &(MODULE_SIZE as u32).to_le_bytes(),
+    );
+    write(image, optional_header + 0x3C, &0x400u32.to_le_bytes());
+    write(image, optional_header + 0x6C, &16u32.to_le_bytes());
+    write(
+        image,
+        optional_header + 0x70,
+        &(EXPORT_DIRECTORY_RVA as u32).to_le_bytes(),
+    );
+    write(
+        image,
+        optional_header + 0x74,
+        &(EXPORT_DIRECTORY_SIZE as u32).to_le_bytes(),
+    );
+
+    let export_directory = EXPORT_DIRECTORY_RVA;
+    let rva = |offset: usize| ((EXPORT_DIRECTORY_RVA + offset) as u32).to_le_bytes();
+
+    write(image, export_directory + 0x14, &1u32.to_le_bytes());
+    write(image, export_directory + 0x18, &1u32.to_le_bytes());
+    write(image, export_directory + 0x1C, &rva(0x28));
+    write(image, export_directory + 0x20, &rva(0x2C));
+    write(image, export_directory + 0x24, &rva(0x30));
+    write(
+        image,
+        export_directory + 0x28,
+        &(CREATE_INTERFACE_RVA as u32).to_le_bytes(),
+    );
+    write(image, export_directory + 0x2C, &rva(0x38));
+    write(image, export_directory + 0x38, b"CreateInterface\0");
+
+    write(image, section_header, b".text\0\0\0");
+    write(
+        image,
+        section_header + 0x8,
+        &((MODULE_SIZE - CODE_RVA) as u32).to_le_bytes(),
+    );
+    write(
+        image,
+        section_header + 0xC,
+        &(CODE_RVA as u32).to_le_bytes(),
+    );
+    write(
+        image,
+        section_header + 0x10,
+        &((MODULE_SIZE - CODE_RVA) as u32).to_le_bytes(),
+    );
+    write(image, section_header + 0x14, &0x400u32.to_le_bytes());
+    write(image, section_header + 0x24, &0xE0000020u32.to_le_bytes());
+}
+
+/// Walks every class and field the way `dump_schemas` does and returns the number of fields.
+fn traverse(session: &Session) -> Result<usize> {
+    let schema_system = SchemaSystem::new(session)?;
+
+    let mut field_count = 0;
+
+    for type_scope in schema_system.type_scopes()? {
+        type_scope.module_name()?;
+
+        for class in type_scope.classes()? {
+            for field in class.fields()? {
+                field.name()?;
+                field.offset()?;
+                field.r#type()?.name()?;
+
+                field_count += 1;
+            }
+        }
+    }
+
+    Ok(field_count)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn traverse_mock_schema_system() -> Result<()> {
+        let mock = MockSchemaSystem::generate(2, 600);
+
+        let session = Session::new(Process::with_source(mock.build()))?;
+
+        let schema_system = SchemaSystem::new(&session)?;
+
+        let type_scopes = schema_system.type_scopes()?;
+
+        assert_eq!(type_scopes.len(), mock.type_scopes.len());
+
+        for (type_scope, expected) in type_scopes.iter().zip(&mock.type_scopes) {
+            assert_eq!(type_scope.module_name()?, expected.module_name);
+
+            let classes = type_scope.classes()?;
+
+            assert_eq!(classes.len(), expected.classes.len());
+
+            for (class, expected) in classes.iter().zip(&expected.classes) {
+                assert_eq!(class.name(), expected.name);
+
+                let fields = class.fields()?;
+
+                assert_eq!(fields.len(), expected.fields.len());
+
+                for (field, expected) in fields.iter().zip(&expected.fields) {
+                    assert_eq!(field.name()?, expected.name);
+                    assert_eq!(field.offset()?, expected.offset);
+                }
+            }
+        }
+
+        Ok(())
+    }
+
+    #[test]
+    fn find_schema_system() -> Result<()> {
+        let mut mock = MockSchemaSystem::generate(1, 10);
+
+        // Through the interface registry, and by scanning if the interface isn't registered.
+        for register_interface in [true, false] {
+            mock.register_interface = register_interface;
+
+            let session = Session::new(Process::with_source(mock.build()))?;
+
+            assert_eq!(
+                SchemaSystem::find_registered(&session)?,
+                register_interface.then_some(MODULE_BASE + SCHEMA_SYSTEM_RVA)
+            );
+
+            assert_eq!(SchemaSystem::new(&session)?.type_scopes()?.len(), 1);
+        }
+
+        Ok(())
+    }
+
+    /// Run with `cargo test --release bench_schema_traversal -- --ignored --nocapture`.
+    #[test]
+    #[ignore]
+    fn bench_schema_traversal() -> Result<()> {
+        let mock = MockSchemaSystem::generate(3, 10000);
+
+        let session = Session::new(Process::with_source(mock.build()))?;
+
+        let start_time = Instant::now();
+
+        let field_count = traverse(&session)?;
+
+        let duration = start_time.elapsed();
+
+        println!(
+            "Traversed {} classes and {} fields in {:?} ({:.0} classes/s)",
+            mock.class_count(),
+            field_count,
+            duration,
+            mock.class_count() as f64 / duration.as_secs_f64()
+        );
+
+        Ok(())
+    }
+}
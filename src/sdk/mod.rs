@@ -1,3 +1,4 @@
+pub use interface_registry::InterfaceRegistry;
 pub use schema_class_field_data::SchemaClassFieldData;
 pub use schema_class_info::SchemaClassInfo;
 pub use schema_system::SchemaSystem;
@@ -6,6 +7,9 @@ pub use schema_type::SchemaType;
 pub use schema_type_declared_class::SchemaTypeDeclaredClass;
 pub use utl_ts_hash::UtlTsHash;
 
+pub mod interface_registry;
+#[cfg(test)]
+pub mod mock_schema_system;
 pub mod schema_class_field_data;
 pub mod schema_class_info;
 pub mod schema_system;
@@ -1,7 +1,7 @@
 use crate::error::Result;
 use crate::remote::Process;
 
-use super::SchemaClassFieldData;
+use super::{SchemaClassFieldData, SchemaTypeDeclaredClass};
 
 pub struct SchemaClassInfo<'a> {
     process: &'a Process,
@@ -45,4 +45,24 @@ impl<'a> SchemaClassInfo<'a> {
     pub fn fields_count(&self) -> Result<u16> {
         self.process.read_memory::<u16>(self.address + 0x1C)
     }
+
+    pub fn parent(&self) -> Result<Option<SchemaClassInfo<'_>>> {
+        let base_classes_count = self.process.read_memory::<u8>(self.address + 0x23)?;
+
+        if base_classes_count == 0 {
+            return Ok(None);
+        }
+
+        let base_classes_ptr = self.process.read_memory::<usize>(self.address + 0x38)?;
+
+        let address = self.process.read_memory::<usize>(base_classes_ptr + 0x8)?;
+
+        let name = SchemaTypeDeclaredClass::new(self.process, address).name()?;
+
+        Ok(Some(SchemaClassInfo::new(self.process, address, &name)))
+    }
+
+    pub fn size(&self) -> Result<i32> {
+        self.process.read_memory::<i32>(self.address + 0x18)
+    }
 }
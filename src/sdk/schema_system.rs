@@ -2,6 +2,7 @@ use std::mem;
 
 use crate::error::Result;
 use crate::remote::Process;
+use crate::session::Session;
 
 use super::SchemaSystemTypeScope;
 
@@ -11,17 +12,63 @@ pub struct SchemaSystem<'a> {
 }
 
 impl<'a> SchemaSystem<'a> {
-    pub fn new(process: &'a Process) -> Result<Self> {
-        let mut address = process.find_pattern(
-            "schemasystem.dll",
-            "48 8D 0D ? ? ? ? E9 ? ? ? ? CC CC CC CC 48 8D 0D ? ? ? ? E9 ? ? ? ? CC CC CC CC 48 83 EC 28"
-        )?;
+    pub fn new(session: &'a Session) -> Result<Self> {
+        let process = session.process();
+
+        let address = match Self::find_registered(session) {
+            Ok(Some(address)) => address,
+            result => {
+                match result {
+                    Err(e) => log::debug!(
+                        "Failed to look up SchemaSystem_001: {}, scanning schemasystem.dll.",
+                        e
+                    ),
+                    _ => log::debug!(
+                        "SchemaSystem_001 is not registered, scanning schemasystem.dll."
+                    ),
+                }
+
+                let address = session.find_pattern(
+                    "schemasystem.dll",
+                    "48 8D 0D ? ? ? ? E9 ? ? ? ? CC CC CC CC 48 8D 0D ? ? ? ? E9 ? ? ? ? CC CC CC CC 48 83 EC 28"
+                )?;
 
-        address = process.resolve_rip(address, None, None)?;
+                session.resolve_rip(address, None, None)?
+            }
+        };
 
         Ok(Self { process, address })
     }
 
+    /// Resolves `CSchemaSystem` through the `SchemaSystem_001` entry of the interface registry.
+    pub fn find_registered(session: &Session) -> Result<Option<usize>> {
+        let process = session.process();
+
+        let Some(registry) = session.interface_registry("schemasystem.dll")? else {
+            return Ok(None);
+        };
+
+        let names: Vec<usize> = registry.regs().iter().map(|reg| reg.name).collect();
+
+        let Some((reg, _)) = registry
+            .regs()
+            .iter()
+            .zip(process.read_strings(&names))
+            .find(|(_, name)| matches!(name.as_deref(), Ok("SchemaSystem_001")))
+        else {
+            return Ok(None);
+        };
+
+        // The factory of a global interface is `lea rax, [rip + instance]; ret`.
+        let code = process.read_memory::<[u8; 8]>(reg.create_fn)?;
+
+        if code[..3] != [0x48, 0x8D, 0x05] || code[7] != 0xC3 {
+            return Ok(None);
+        }
+
+        process.resolve_rip(reg.create_fn, None, None).map(Some)
+    }
+
     pub fn type_scopes(&self) -> Result<Vec<SchemaSystemTypeScope>> {
         let size = self.process.read_memory::<u32>(self.address + 0x190)?;
         let data = self.process.read_memory::<usize>(self.address + 0x198)?;
@@ -54,6 +54,15 @@ impl<'a> SchemaType<'a> {
         Ok(Self::convert_type_name(&name))
     }
 
+    /// Returns the normalized name of `type_name` if it is one of the primitive types that
+    /// `name` converts, e.g. `int32_t` for both `int32` and `int32_t`.
+    pub fn primitive_type_name(type_name: &str) -> Option<&'static str> {
+        TYPE_MAP
+            .iter()
+            .find(|(k, v)| *k == type_name || *v == type_name)
+            .map(|(_, v)| *v)
+    }
+
     fn convert_type_name(type_name: &str) -> String {
         let mut result = type_name.to_string();
 
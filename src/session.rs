@@ -0,0 +1,479 @@
+use std::collections::HashMap;
+use std::slice;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::{Arc, Mutex};
+
+use crate::error::{Error, Result};
+use crate::mem::scanner::SCAN_CHUNK_SIZE;
+use crate::mem::{Pattern, Scanner};
+use crate::remote::{process, Module, ModuleEntry, Process};
+use crate::sdk::InterfaceRegistry;
+
+const PAGE_SIZE: usize = 0x1000;
+
+/// Values computed at most once per key, even when several threads ask for the same key at once.
+///
+/// Failures are not cached, so the next caller retries.
+struct Cache<T> {
+    slots: Mutex<HashMap<String, Arc<Mutex<Option<Arc<T>>>>>>,
+}
+
+impl<T> Cache<T> {
+    fn new() -> Self {
+        Self {
+            slots: Mutex::new(HashMap::new()),
+        }
+    }
+
+    /// Returns the cached value for `key`, or stores the result of `init`. The flag is set if
+    /// the value was already cached.
+    fn get_or_try_insert<F>(&self, key: &str, init: F) -> Result<(Arc<T>, bool)>
+    where
+        F: FnOnce() -> Result<T>,
+    {
+        let slot = self
+            .slots
+            .lock()
+            .unwrap()
+            .entry(key.to_string())
+            .or_default()
+            .clone();
+
+        // Only callers of the same key wait on each other.
+        let mut value = slot.lock().unwrap();
+
+        if let Some(value) = &*value {
+            return Ok((value.clone(), true));
+        }
+
+        let inserted = Arc::new(init()?);
+
+        *value = Some(inserted.clone());
+
+        Ok((inserted, false))
+    }
+
+    fn get(&self, key: &str) -> Option<Arc<T>> {
+        let slot = self.slots.lock().unwrap().get(key)?.clone();
+
+        let value = slot.lock().unwrap();
+
+        value.clone()
+    }
+}
+
+/// A copy of a module image, with the pages that could not be read left zeroed.
+pub struct ModuleImage {
+    base: usize,
+    data: Vec<u8>,
+    readable: Vec<bool>,
+}
+
+impl ModuleImage {
+    fn new(process: &Process, entry: &ModuleEntry) -> Self {
+        let mut data = vec![0; entry.size];
+        let mut readable = vec![false; entry.size.div_ceil(PAGE_SIZE)];
+
+        let start = entry.base;
+        let end = start + entry.size;
+
+        let ranges = match process.regions() {
+            Some(regions) => regions.readable_ranges(start, end),
+            None => vec![(start, end)],
+        };
+
+        for (start, end) in ranges {
+            let mut address = start;
+
+            while address < end {
+                let len = SCAN_CHUNK_SIZE.min(end - address);
+
+                let offset = address - entry.base;
+
+                // A chunk that fails to read is retried page by page.
+                let chunk = &mut data[offset..offset + len];
+
+                if process
+                    .read_memory_raw(address, chunk.as_mut_ptr() as *mut _, len)
+                    .is_ok()
+                {
+                    Self::mark(&mut readable, offset, len);
+                } else {
+                    let mut page = address;
+
+                    while page < address + len {
+                        let page_len = (PAGE_SIZE - page % PAGE_SIZE).min(address + len - page);
+
+                        let offset = page - entry.base;
+
+                        let buffer = &mut data[offset..offset + page_len];
+
+                        if process
+                            .read_memory_raw(page, buffer.as_mut_ptr() as *mut _, page_len)
+                            .is_ok()
+                        {
+                            Self::mark(&mut readable, offset, page_len);
+                        }
+
+                        page += page_len;
+                    }
+                }
+
+                address += len;
+            }
+        }
+
+        Self {
+            base: entry.base,
+            data,
+            readable,
+        }
+    }
+
+    fn mark(readable: &mut [bool], offset: usize, len: usize) {
+        for page in offset / PAGE_SIZE..(offset + len).div_ceil(PAGE_SIZE) {
+            readable[page] = true;
+        }
+    }
+
+    #[inline]
+    pub fn base(&self) -> usize {
+        self.base
+    }
+
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.data.len()
+    }
+
+    /// Copies `buffer.len()` bytes from `address`, or returns `false` if any of them lie outside
+    /// the image or on a page that couldn't be read.
+    pub fn read(&self, address: usize, buffer: &mut [u8]) -> bool {
+        let Some(offset) = address.checked_sub(self.base) else {
+            return false;
+        };
+
+        if !self.is_readable(offset, buffer.len()) {
+            return false;
+        }
+
+        buffer.copy_from_slice(&self.data[offset..offset + buffer.len()]);
+
+        true
+    }
+
+    /// Returns the matches of `pattern` that lie entirely within `start..end` and on pages that
+    /// could be read.
+    pub fn find_all<'a>(
+        &'a self,
+        pattern: &'a Pattern,
+        start: usize,
+        end: usize,
+    ) -> impl Iterator<Item = usize> + 'a {
+        let clamp =
+            |address: usize| address.clamp(self.base, self.base + self.data.len()) - self.base;
+
+        pattern
+            .find_all(&self.data[..clamp(end)], clamp(start))
+            .filter(move |&offset| self.is_readable(offset, pattern.len()))
+            .map(move |offset| self.base + offset)
+    }
+
+    fn is_readable(&self, offset: usize, len: usize) -> bool {
+        let end = offset.saturating_add(len);
+
+        end <= self.data.len()
+            && (len == 0
+                || self.readable[offset / PAGE_SIZE..end.div_ceil(PAGE_SIZE)]
+                    .iter()
+                    .all(|&readable| readable))
+    }
+}
+
+/// Counters of the work done and saved by a session.
+#[derive(Default)]
+pub struct SessionStats {
+    pub module_parses: AtomicUsize,
+    pub module_hits: AtomicUsize,
+    pub image_reads: AtomicUsize,
+    pub image_bytes: AtomicUsize,
+    pub image_hits: AtomicUsize,
+    pub registry_walks: AtomicUsize,
+    pub registry_hits: AtomicUsize,
+    pub cached_reads: AtomicUsize,
+    pub uncached_reads: AtomicUsize,
+}
+
+/// State shared by all dumpers of a run.
+///
+/// The module table is read once, and each module's headers, image and interface registry are
+/// only read the first time any dumper asks for them. Reads that fall within a cached image are
+/// served from it instead of the process.
+pub struct Session {
+    process: Process,
+    modules: Vec<ModuleEntry>,
+    parsed: Cache<Module>,
+    images: Cache<ModuleImage>,
+    registries: Cache<Option<Arc<InterfaceRegistry>>>,
+    stats: SessionStats,
+}
+
+impl Session {
+    pub fn new(process: Process) -> Result<Self> {
+        let modules = process.modules()?;
+
+        Ok(Self {
+            process,
+            modules,
+            parsed: Cache::new(),
+            images: Cache::new(),
+            registries: Cache::new(),
+            stats: SessionStats::default(),
+        })
+    }
+
+    #[inline]
+    pub fn process(&self) -> &Process {
+        &self.process
+    }
+
+    #[inline]
+    pub fn stats(&self) -> &SessionStats {
+        &self.stats
+    }
+
+    pub fn module_names(&self) -> impl Iterator<Item = &str> {
+        self.modules.iter().map(|module| module.name.as_str())
+    }
+
+    /// Returns the base address of a module without parsing its headers.
+    pub fn module_base(&self, module_name: &str) -> Result<usize> {
+        Ok(self.module_entry(module_name)?.base)
+    }
+
+    fn module_at(&self, address: usize) -> Option<&ModuleEntry> {
+        self.modules
+            .iter()
+            .find(|module| address >= module.base && address < module.base + module.size)
+    }
+
+    fn module_entry(&self, module_name: &str) -> Result<&ModuleEntry> {
+        self.modules
+            .iter()
+            .find(|module| module.name == module_name)
+            .ok_or(Error::ModuleNotFound)
+    }
+
+    /// Returns the parsed headers, exports and sections of a module.
+    pub fn module(&self, module_name: &str) -> Result<Arc<Module>> {
+        let entry = self.module_entry(module_name)?;
+
+        let (module, hit) = self
+            .parsed
+            .get_or_try_insert(module_name, || Module::new(&self.process, entry.base))?;
+
+        Self::count(hit, &self.stats.module_hits, &self.stats.module_parses);
+
+        Ok(module)
+    }
+
+    /// Returns a copy of a module image, which is read in full the first time it is needed.
+    pub fn image(&self, module_name: &str) -> Result<Arc<ModuleImage>> {
+        let entry = self.module_entry(module_name)?;
+
+        let (image, hit) = self.images.get_or_try_insert(module_name, || {
+            self.stats
+                .image_bytes
+                .fetch_add(entry.size, Ordering::Relaxed);
+
+            Ok(ModuleImage::new(&self.process, entry))
+        })?;
+
+        Self::count(hit, &self.stats.image_hits, &self.stats.image_reads);
+
+        Ok(image)
+    }
+
+    /// Returns the interface registry of a module, or `None` if it doesn't export
+    /// `CreateInterface`.
+    pub fn interface_registry(&self, module_name: &str) -> Result<Option<Arc<InterfaceRegistry>>> {
+        let (registry, hit) = self.registries.get_or_try_insert(module_name, || {
+            Ok(InterfaceRegistry::new(&self.process, &*self.module(module_name)?)?.map(Arc::new))
+        })?;
+
+        Self::count(hit, &self.stats.registry_hits, &self.stats.registry_walks);
+
+        Ok((*registry).clone())
+    }
+
+    pub fn find_pattern(&self, module_name: &str, pattern: &str) -> Result<usize> {
+        let pattern = Pattern::new(pattern)?;
+
+        self.find_patterns(module_name, slice::from_ref(&pattern))?[0].ok_or(Error::PatternNotFound)
+    }
+
+    /// Finds the first match of every pattern in a single pass over the module image.
+    pub fn find_patterns(
+        &self,
+        module_name: &str,
+        patterns: &[Pattern],
+    ) -> Result<Vec<Option<usize>>> {
+        Ok(self
+            .find_pattern_matches(module_name, patterns, 1)?
+            .into_iter()
+            .map(|matches| matches.first().copied())
+            .collect())
+    }
+
+    /// Finds up to `max_matches` matches of every pattern in a single pass over the module
+    /// image.
+    pub fn find_pattern_matches(
+        &self,
+        module_name: &str,
+        patterns: &[Pattern],
+        max_matches: usize,
+    ) -> Result<Vec<Vec<usize>>> {
+        let image = self.image(module_name)?;
+
+        let mut scanner = Scanner::new(patterns, max_matches);
+
+        scanner.scan(image.base(), image.len(), |address, buffer| {
+            image.read(address, buffer)
+        });
+
+        Ok(scanner.into_matches())
+    }
+
+    /// Finds up to `max_matches` matches of `pattern` between `start` and `end` in the image of
+    /// the module that overlaps them, without scanning the rest of the module.
+    pub fn find_pattern_in(
+        &self,
+        pattern: &Pattern,
+        start: usize,
+        end: usize,
+        max_matches: usize,
+    ) -> Result<Vec<usize>> {
+        let module = self
+            .modules
+            .iter()
+            .find(|module| start < module.base + module.size && module.base < end)
+            .ok_or(Error::InvalidAddress(start))?;
+
+        let image = self.image(&module.name)?;
+
+        Ok(image
+            .find_all(pattern, start, end)
+            .take(max_matches)
+            .collect())
+    }
+
+    /// Reads from a cached module image if one covers the range, and from the process otherwise.
+    pub fn read_memory_raw(&self, address: usize, buffer: &mut [u8]) -> Result<()> {
+        let image = self
+            .module_at(address)
+            .and_then(|module| self.images.get(&module.name));
+
+        if let Some(image) = image {
+            if image.read(address, buffer) {
+                self.stats.cached_reads.fetch_add(1, Ordering::Relaxed);
+
+                return Ok(());
+            }
+        }
+
+        self.stats.uncached_reads.fetch_add(1, Ordering::Relaxed);
+
+        self.process
+            .read_memory_raw(address, buffer.as_mut_ptr() as *mut _, buffer.len())
+    }
+
+    pub fn read_memory<T>(&self, address: usize) -> Result<T> {
+        process::read_with(address, |address, buffer| {
+            self.read_memory_raw(address, buffer)
+        })
+    }
+
+    pub fn resolve_jmp(
+        &self,
+        address: usize,
+        offset: Option<usize>,
+        length: Option<usize>,
+    ) -> Result<usize> {
+        process::resolve_jmp_with(address, offset, length, |address, buffer| {
+            self.read_memory_raw(address, buffer)
+        })
+    }
+
+    pub fn resolve_rip(
+        &self,
+        address: usize,
+        offset: Option<usize>,
+        length: Option<usize>,
+    ) -> Result<usize> {
+        process::resolve_rip_with(address, offset, length, |address, buffer| {
+            self.read_memory_raw(address, buffer)
+        })
+    }
+
+    pub fn log_stats(&self) {
+        let stats = &self.stats;
+
+        let load = |counter: &AtomicUsize| counter.load(Ordering::Relaxed);
+
+        log::debug!(
+            "Session: {} modules parsed ({} reused), {} images read ({} bytes, {} reused), {} registries walked ({} reused), {} reads from images, {} from the process.",
+            load(&stats.module_parses),
+            load(&stats.module_hits),
+            load(&stats.image_reads),
+            load(&stats.image_bytes),
+            load(&stats.image_hits),
+            load(&stats.registry_walks),
+            load(&stats.registry_hits),
+            load(&stats.cached_reads),
+            load(&stats.uncached_reads)
+        );
+    }
+
+    fn count(hit: bool, hits: &AtomicUsize, misses: &AtomicUsize) {
+        if hit { hits } else { misses }.fetch_add(1, Ordering::Relaxed);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    use crate::sdk::mock_schema_system::MockSchemaSystem;
+
+    #[test]
+    fn reuse_module_data() -> Result<()> {
+        let mock = MockSchemaSystem::generate(1, 10);
+
+        let session = Session::new(Process::with_source(mock.build()))?;
+
+        for _ in 0..2 {
+            session.module("schemasystem.dll")?;
+            session.interface_registry("schemasystem.dll")?;
+            session.find_pattern_matches("schemasystem.dll", &[Pattern::new("48 8D 05")?], 1)?;
+        }
+
+        let stats = session.stats();
+
+        // The registry walk parses the module once, every later lookup is a hit.
+        assert_eq!(stats.module_parses.load(Ordering::Relaxed), 1);
+        assert_eq!(stats.module_hits.load(Ordering::Relaxed), 2);
+        assert_eq!(stats.image_reads.load(Ordering::Relaxed), 1);
+        assert_eq!(stats.registry_walks.load(Ordering::Relaxed), 1);
+
+        // Reads inside the image no longer reach the process.
+        let base = session.module("schemasystem.dll")?.base();
+
+        assert_eq!(
+            session.read_memory::<u16>(base)?,
+            session.process().read_memory::<u16>(base)?
+        );
+        assert_eq!(stats.cached_reads.load(Ordering::Relaxed), 1);
+
+        Ok(())
+    }
+}